@@ -0,0 +1,1011 @@
+#pragma once
+
+// Scene description, distance functions and shading shared by every ray marching pass
+
+// Objects and point lights live in std430 storage buffers, the member order keeps
+// them tightly packed and must match the GPU structs in Objects.cpp / LightingSystem.cpp
+struct PointLight {
+    vec3 position;
+    float constant;
+    vec3 ambient;
+    float linear;
+    vec3 diffuse;
+    float quadratic;
+    vec3 specular;
+    vec3 color;
+};
+
+struct DirLight {
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    vec3 color;
+};
+
+struct Sphere {
+	vec3 center;
+	float radius;
+	vec3 color;
+	float reflection;
+};
+
+struct Cube {
+	mat4 inverseTransormation;
+	vec3 halfSize;
+	float reflection;
+	vec3 color;
+	float rounding;
+};
+
+struct Capsule {
+	mat4 inverseTransormation;
+	vec3 pos1;
+	float reflection;
+	vec3 pos2;
+	float radius;
+	vec3 color;
+};
+
+// Any type from the primitive registry, distances come from primitiveSDF() in the generated Primitives.glsl
+struct Primitive {
+	mat4 inverseTransormation;
+	vec4 a;
+	vec4 b;
+	vec3 color;
+	float reflection;
+	vec3 lodCenter; // World space bounding sphere, see primitiveDist()
+	float lodRadius;
+	int type;
+};
+
+// Per node bounds and material of the compiled CSG shapes, the tree itself is in the generated Csg.glsl
+struct CsgBounds {
+	vec4 lower;
+	vec4 upper;
+};
+
+// codeStart is -1 for compiled shapes, the others run their bytecode with csgRun().
+// boundsSlot is the box around the whole shape
+struct CsgShape {
+	vec3 color;
+	float reflection;
+	int codeStart;
+	int codeEnd;
+	int boundsSlot;
+};
+
+struct CsgInstruction {
+	vec3 pivot;
+	float blend;
+	vec3 spacing;
+	int op;
+	ivec3 limit;
+	int arg;
+};
+
+// Opcodes, Csg::Opcode in Csg.hpp
+#define CSG_LEAF 0
+#define CSG_UNION 1
+#define CSG_SUBTRACT 2
+#define CSG_INTERSECT 3
+#define CSG_PUSH_BEND 4
+#define CSG_POP 5
+#define CSG_REPEAT 6
+#define CSG_END_REPEAT 7
+#define CSG_STACK_SIZE 16
+#define CSG_TRANSFORM_STACK 8
+#define CSG_REPEAT_STACK 2
+
+// Types: 
+#define NONE -1
+#define LIGHT 0
+#define SPHERE 1
+#define CUBE 2
+#define CAPSULE 3
+#define PRIMITIVE 4
+#define CSG 5
+
+struct Object {
+	int type;
+	int idx;
+};
+
+struct Intersect {
+	float dist;
+	Object obj;
+};
+
+// Everything that is the same for every pass of a frame, written once per frame by FrameUniforms.cpp
+// and shared by all programs. std140, the member order must match GPUFrame there
+layout (std140, binding = 0) uniform Frame {
+    mat3 viewMatrix;
+    mat3 lastViewMatrix; // View of the previous frame, for temporal reprojection
+    vec3 position;
+    float time;
+    vec3 lastPosition;
+    int frameIndex;
+    vec3 inDir;
+    float maxDist;
+    vec2 iResolution;
+    float maxShadowDist;
+    float surfaceEpsilon;
+    DirLight dirLight;
+};
+
+#define MAX_DIST maxDist
+#define MAX_SHADOW_DIST maxShadowDist
+#define eplison surfaceEpsilon
+#define NORMAL_INCREMENT 0.01
+#define LIGHT_RADIUS 1.0
+
+// Objects
+layout (std430, binding = 4) readonly buffer Spheres { Sphere spheres[]; };
+layout (std430, binding = 5) readonly buffer Cubes { Cube cubes[]; };
+layout (std430, binding = 6) readonly buffer Capsules { Capsule capsules[]; };
+layout (std430, binding = 7) readonly buffer PointLights { PointLight pointLights[]; };
+layout (std430, binding = 8) readonly buffer Primitives { Primitive primitives[]; };
+layout (std430, binding = 9) readonly buffer CsgLeaves { Primitive csgLeaves[]; };
+layout (std430, binding = 10) readonly buffer CsgNodeBounds { CsgBounds csgBounds[]; };
+layout (std430, binding = 11) readonly buffer CsgShapes { CsgShape csgShapes[]; };
+layout (std430, binding = 12) readonly buffer CsgCode { CsgInstruction csgCode[]; };
+uniform int sphereCount;
+uniform int cubeCount;
+uniform int capsuleCount;
+uniform int primitiveCount;
+uniform int csgCount;
+uniform vec3 sceneMin; // Box around every object, see Objects::sceneBounds
+uniform vec3 sceneMax;
+uniform bool sceneUnbounded; // A CSG shape repeats forever outside the box
+uniform int lightCount;
+uniform bool showLights;
+uniform bool useAnalytic; // Spheres, sharp cubes and capsules are intersected by analyticHit() instead of marched
+// Reflections
+uniform int maxBounces;
+uniform int stepBudget;
+uniform float minReflectance;
+uniform bool cheapBounceLighting;
+// Level of detail
+uniform float lodEpsilon; // Hit tolerance in pixels, below eplison the fixed tolerance is kept
+uniform float lodPixels; // Objects smaller than this on screen are replaced by their bounds
+uniform float lodShadeDistance; // Hits farther from the camera skip shadows and reflections
+// Brick map of the static objects, see BrickMap.cpp. Cells without a brick store a lower bound on
+// their distance, cells near a surface point to a brick of BRICK_RES^3 voxels in the atlas
+#define BRICK_RES 8
+uniform bool useBrickMap;
+uniform vec3 brickOrigin;
+uniform float brickCellSize;
+uniform ivec3 brickCells;
+uniform int brickAtlasBricks; // Bricks along each side of the atlas
+uniform float brickBand; // Closer than this the objects are evaluated exactly
+layout (binding = 1) uniform sampler3D brickCoarse;
+layout (binding = 2) uniform isampler3D brickIndex;
+layout (binding = 3) uniform sampler3D brickAtlas;
+// Uniform grid over the same objects, see UniformGrid.cpp. gridObjects holds the packed objects
+// tested everywhere first, then the list of every cell
+struct GridCell {
+	int start;
+	int count;
+	float empty; // Lower bound on the distance to every object, for cells without any
+	int padding;
+};
+layout (std430, binding = 14) readonly buffer GridCells { GridCell gridCellData[]; };
+layout (std430, binding = 15) readonly buffer GridObjects { int gridObjects[]; };
+uniform bool useGrid;
+uniform vec3 gridOrigin;
+uniform float gridCellSize;
+uniform ivec3 gridCells;
+uniform int gridUnbounded;
+// Per screen tile lists of the same objects for primary rays, see TileCulling.cpp.
+// cullObjects holds the packed objects every tile tests first, then the list of every tile.
+// Only the passes marching camera rays define PRIMARY_RAYS, the others would declare the two
+// blocks for nothing and compute stages may only have 16 (8 is the minimum)
+#ifdef PRIMARY_RAYS
+struct CullTile {
+	int start;
+	int count;
+};
+layout (std430, binding = 16) readonly buffer CullTiles { CullTile cullTiles[]; };
+layout (std430, binding = 17) readonly buffer CullObjects { int cullObjects[]; };
+uniform bool useTileCulling;
+uniform int cullTileSize; // In pixels
+uniform int cullTilesX;
+uniform int cullUnbounded;
+#endif
+
+// Normal Increments
+vec3 dx = {NORMAL_INCREMENT, 0, 0};
+vec3 dy = {0, NORMAL_INCREMENT, 0};
+vec3 dz = {0, 0, NORMAL_INCREMENT};
+
+// March steps taken by this pixel, shared by the primary ray and all bounces
+int marchSteps = 0;
+// Set by march() when it returned NONE because marchSteps reached stepBudget, not because the ray missed
+bool stepsExhausted = false;
+// Objects with a bounding radius under this are replaced by their bounds, set by sceneDist() for the point it evaluates
+float lodSize = 0.0;
+
+#ifdef PRIMARY_RAYS
+// Tile of the primary ray being marched, -1 for rays that may leave the tile's frustum
+int primaryTile = -1;
+#endif
+
+#include "Primitives.glsl"
+
+float sphereSDF(vec3 pos, Sphere sphere);
+float cubeSDF(vec3 pos, Cube cube);
+float capsuleSDF( vec3 pos, Capsule capsule);
+float primitiveDist(vec3 pos, Primitive primitive);
+float shadow(vec3 origin, vec3 dir, float maxDist, Object obj);
+vec3 getBend(vec3 p, float k);
+vec3 getSphereNormal(vec3 pos, Sphere sphere);
+vec3 getCubeNormal(vec3 pos, Cube cube);
+vec3 getPrimitiveNormal(vec3 pos, Primitive primitive);
+vec3 getCsgNormal(vec3 pos, int shape);
+vec3 getColor(Intersect intersect, vec3 pos, vec3 dir);
+void surface(Intersect intersect, vec3 pos, out vec3 normal, out vec3 color, out float reflection);
+vec3 shade(Intersect intersect, vec3 pos, bool shadows, out vec3 normal, out float reflection);
+Intersect march(inout vec3 pos, vec3 dir, Object ignore);
+Intersect marchPrimary(inout vec3 pos, vec3 dir, ivec2 pixel);
+vec3 rayMarch(vec3 pos, ivec2 pixel);
+vec3 calculateDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 color, vec3 fragPos, Object obj, bool shadows);
+vec3 calculatePointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 color, Object obj, bool shadows);
+vec3 calculateLight(vec3 pos, vec3 normal, vec3 inColor, Object obj, bool shadows);
+Intersect sceneDist(vec3 pos, vec3 direction, Object ignore);
+Intersect lightProxies(vec3 origin, vec3 dir, float maxDist);
+Intersect analyticHit(vec3 origin, vec3 dir, float maxDist, Object ignore);
+
+// CSG helpers, Csg.cpp has the same functions for the CPU
+float smoothMin(float a, float b, float k) {
+	if (k <= 0.0) return min(a, b);
+	float h = max(k - abs(a - b), 0.0) / k;
+	return min(a, b) - h * h * k * 0.25;
+}
+
+float smoothMax(float a, float b, float k) {
+	return -smoothMin(-a, -b, k);
+}
+
+// Bends around the z axis, the angle grows along x
+vec3 getBend(vec3 p, float k) {
+	float c = cos(k * p.x);
+	float s = sin(k * p.x);
+	return vec3(c * p.x - s * p.y, s * p.x + c * p.y, p.z);
+}
+
+// Hash of a repetition cell in [0, 1], exact so Csg::hash() gets the same values
+float csgHash(ivec3 cell) {
+	uvec3 c = uvec3(cell);
+	uint h = (c.x * 73856093u) ^ (c.y * 19349663u) ^ (c.z * 83492791u);
+	h = (h ^ (h >> 16)) * 0x45d9f3bu;
+	h ^= h >> 16;
+	return float(h & 0xffffu) / 65535.0;
+}
+
+// Moves p into one of the cells nearest to it, iterations 0 to 7 step towards the neighbor cell on the axes of their bits.
+// Axes with a spacing of 0 are not repeated, and limit clamps the cells on the others unless it is 0.
+// Each copy shrinks around the pivot by a random part of jitter, which keeps it inside its cell
+vec3 csgRepeatPoint(vec3 p, vec3 pivot, vec3 spacing, ivec3 limit, float jitter, int iteration, out float scale) {
+	vec3 local = p - pivot;
+	vec3 x = local / max(spacing, vec3(1e-6));
+	vec3 id = floor(x + 0.5);
+	id += vec3(iteration & 1, (iteration >> 1) & 1, (iteration >> 2) & 1) * sign(x - id);
+	id = mix(id, clamp(id, -vec3(limit), vec3(limit)), greaterThan(limit, ivec3(0)));
+	id = mix(vec3(0.0), id, greaterThan(spacing, vec3(0.0)));
+	scale = 1.0 - jitter * csgHash(ivec3(id));
+	return (local - spacing * id) / scale + pivot;
+}
+
+// Iterations that step along an axis which isn't repeated would only evaluate the same cell again
+bool csgRepeatSkips(vec3 spacing, int iteration) {
+	ivec3 steps = ivec3(iteration & 1, (iteration >> 1) & 1, (iteration >> 2) & 1);
+	return any(greaterThan(steps, ivec3(greaterThan(spacing, vec3(0.0)))));
+}
+
+// Distance to a node's bounds, 0 inside them
+float csgBoxDist(vec3 p, int slot) {
+	vec3 q = max(csgBounds[slot].lower.xyz - p, p - csgBounds[slot].upper.xyz);
+	return length(max(q, 0.0));
+}
+
+// Box distance of a shape or union child too small on screen to show its detail, -1 otherwise
+float csgLod(vec3 p, int slot) {
+	if (slot < 0) return -1.0;
+	vec3 size = csgBounds[slot].upper.xyz - csgBounds[slot].lower.xyz;
+	if (length(size) * 0.5 >= lodSize) return -1.0;
+	return csgBoxDist(p, slot);
+}
+
+#include "Csg.glsl"
+
+// Stack machine for the dynamic shapes, same as Csg::run()
+float csgRun(vec3 p, int shape, float limit) {
+	float bounds = csgBoxDist(p, csgShapes[shape].boundsSlot);
+	if (bounds > limit) return bounds;
+
+	float stack[CSG_STACK_SIZE];
+	vec3 transforms[CSG_TRANSFORM_STACK];
+	vec3 repeatOrigins[CSG_REPEAT_STACK];
+	float repeatScales[CSG_REPEAT_STACK];
+	int repeatIterations[CSG_REPEAT_STACK];
+	int top = 0;
+	int saved = 0;
+	int loops = 0;
+
+	int end = csgShapes[shape].codeEnd;
+	for (int pc = csgShapes[shape].codeStart; pc < end; ++pc) {
+		CsgInstruction instruction = csgCode[pc];
+		switch (instruction.op) {
+			case CSG_LEAF:
+				stack[top++] = primitiveDist(p, csgLeaves[instruction.arg]);
+				break;
+			case CSG_UNION:
+				--top;
+				stack[top - 1] = smoothMin(stack[top - 1], stack[top], instruction.blend);
+				break;
+			case CSG_SUBTRACT:
+				--top;
+				stack[top - 1] = smoothMax(stack[top - 1], -stack[top], instruction.blend);
+				break;
+			case CSG_INTERSECT:
+				--top;
+				stack[top - 1] = smoothMax(stack[top - 1], stack[top], instruction.blend);
+				break;
+			case CSG_PUSH_BEND:
+				transforms[saved++] = p;
+				p = getBend(p - instruction.pivot, instruction.blend) + instruction.pivot;
+				break;
+			case CSG_POP:
+				p = transforms[--saved];
+				break;
+			case CSG_REPEAT:
+				repeatOrigins[loops] = p;
+				repeatIterations[loops] = 0;
+				stack[top++] = MAX_DIST;
+				p = csgRepeatPoint(p, instruction.pivot, instruction.spacing, instruction.limit, instruction.blend, 0, repeatScales[loops]);
+				++loops;
+				break;
+			case CSG_END_REPEAT: {
+				CsgInstruction repeat = csgCode[instruction.arg];
+				int loop = loops - 1;
+				--top;
+				stack[top - 1] = min(stack[top - 1], stack[top] * repeatScales[loop]);
+
+				int next = repeatIterations[loop] + 1;
+				while (next < 8 && csgRepeatSkips(repeat.spacing, next)) ++next;
+				if (next < 8) {
+					repeatIterations[loop] = next;
+					p = csgRepeatPoint(repeatOrigins[loop], repeat.pivot, repeat.spacing, repeat.limit, repeat.blend, next, repeatScales[loop]);
+					pc = instruction.arg;
+				}
+				else {
+					p = repeatOrigins[loop];
+					--loops;
+				}
+				break;
+			}
+		}
+	}
+	return stack[0];
+}
+
+float csgDist(vec3 p, int shape, float limit) {
+	float lod = csgLod(p, csgShapes[shape].boundsSlot);
+	if (lod >= 0.0) return lod;
+	return csgShapes[shape].codeStart < 0 ? csgSDF(p, shape, limit) : csgRun(p, shape, limit);
+}
+
+// Objects packed into one int, for passes that store them in buffers or images. The type takes the
+// top 8 bits and the index the low 24, the same as packObject() in Objects.hpp
+#define OBJECT_INDEX_BITS 24
+
+int packObject(Object obj) {
+	return (obj.type << OBJECT_INDEX_BITS) | obj.idx;
+}
+
+Object unpackObject(int id) {
+	return Object(id >> OBJECT_INDEX_BITS, id & ((1 << OBJECT_INDEX_BITS) - 1));
+}
+
+vec3 getRayDirection(vec2 fragCoord) {
+	vec2 aspectRatio = vec2(iResolution.x / iResolution.y, 1.0) * 0.5f;
+	vec2 uv = 2.0 * fragCoord / iResolution - 1.0;
+	uv *= aspectRatio;
+	return normalize(vec3(uv, -1.0)) * viewMatrix;
+}
+
+// Width of a pixel's cone at pos, one pixel spans 1 / iResolution.y radians in getRayDirection().
+// Reflected paths are longer than the straight line to the camera, so they only ever keep detail longer
+float pixelFootprint(vec3 pos) {
+	return distance(pos, position) / iResolution.y;
+}
+
+// Distances along the ray where it enters and leaves the scene box, x > y when it misses it.
+// Nothing outside the box can be hit, so the marches only step between the two. Shapes repeated
+// forever are not in the box, while there are any every ray is marched its full length
+vec2 sceneClip(vec3 origin, vec3 dir) {
+	if (sceneUnbounded) return vec2(0.0, MAX_DIST);
+
+	vec3 inverse = 1.0 / dir;
+	vec3 t0 = (sceneMin - origin) * inverse;
+	vec3 t1 = (sceneMax - origin) * inverse;
+	vec3 near = min(t0, t1);
+	vec3 far = max(t0, t1);
+	return vec2(max(max(near.x, near.y), max(near.z, 0.0)), min(min(far.x, far.y), far.z));
+}
+
+// Hit tolerance at pos, distant rays stop once they are within lodEpsilon pixels of a surface
+float hitEpsilon(vec3 pos) {
+	return max(eplison, lodEpsilon * pixelFootprint(pos));
+}
+
+// 1 if nothing but obj is within maxDist along dir, 0 otherwise
+float shadow(vec3 origin, vec3 dir, float maxDist, Object obj) {
+	vec2 clip = sceneClip(origin, dir);
+	maxDist = min(maxDist, clip.y);
+	if (clip.x >= maxDist) return 1.0;
+	if (useAnalytic && analyticHit(origin, dir, maxDist, obj).dist < maxDist) return 0.0;
+	vec3 pos = origin + dir * clip.x;
+	
+	while (distance(pos, origin) < maxDist) {
+		Intersect intersect = sceneDist(pos, dir, obj);
+
+		if (intersect.obj.type != NONE && intersect.dist < hitEpsilon(pos)) return 0.0;
+
+		pos += dir * intersect.dist;
+	}
+
+	return 1.0;
+}
+
+// Unshadowed ambient and direct (diffuse + specular) parts of a light, direct is scaled by shadow visibility
+void dirLightTerms(DirLight light, vec3 normal, vec3 viewDir, vec3 color, out vec3 ambient, out vec3 direct) {
+    light.ambient *= light.color;
+    light.diffuse *= light.color;
+    light.specular *= light.color;
+
+    vec3 lightDir = normalize(-light.direction);
+    vec3 halfwayDir = normalize(lightDir - viewDir);
+
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+
+    // specular shading
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), 10);
+
+    // combine results
+    ambient = light.ambient * color;
+    vec3 diffuse = light.diffuse * diff * color;
+    vec3 specular = light.specular * spec * color;
+    direct = diffuse + specular;
+}
+
+vec3 calculateDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 color, vec3 fragPos, Object obj, bool shadows) {
+    vec3 ambient, direct;
+    dirLightTerms(light, normal, viewDir, color, ambient, direct);
+
+    // Shadow
+    float visibility = shadows ? shadow(fragPos, normalize(-light.direction), MAX_SHADOW_DIST, obj) : 1.0;
+    return ambient + (direct * visibility);
+}
+
+void pointLightTerms(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 color, out vec3 ambient, out vec3 direct) {
+    light.ambient *= light.color;
+    light.diffuse *= light.color;
+    light.specular *= light.color;
+
+    vec3 lightDir = normalize(light.position - fragPos);
+    vec3 halfwayDir = normalize(lightDir - viewDir);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), 10);
+    // attenuation
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+    // combine results
+    ambient  = light.ambient  * color;
+    vec3 diffuse  = light.diffuse  * diff * color;
+    vec3 specular = light.specular * spec * color;
+    ambient  *= attenuation;
+    diffuse  *= attenuation;
+    specular *= attenuation;
+    direct = diffuse + specular;
+}
+
+vec3 calculatePointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 color, Object obj, bool shadows) {
+    vec3 ambient, direct;
+    pointLightTerms(light, normal, fragPos, viewDir, color, ambient, direct);
+
+    float visibility = shadows ? shadow(fragPos, normalize(light.position - fragPos), distance(light.position, fragPos), obj) : 1.0;
+    return ambient + (direct * visibility);
+}
+
+vec3 calculateLight(vec3 pos, vec3 normal, vec3 inColor, Object obj, bool shadows) {
+	vec3 color = vec3(0.0);
+
+	color += calculateDirLight(dirLight, normal, inDir, inColor, pos, obj, shadows);
+
+	for (int i = 0; i < lightCount; ++i)
+		color += calculatePointLight(pointLights[i], normal, pos, inDir, inColor, obj, shadows);
+
+	return color;
+}
+
+float sphereSDF(vec3 pos, Sphere sphere) {
+	return length(pos - sphere.center) - sphere.radius;
+}
+
+float cubeSDF(vec3 pos, Cube cube) {
+	pos = (cube.inverseTransormation * vec4(pos, 1.0)).xyz;
+
+	vec3 d = abs(pos) - cube.halfSize;
+    return length(max(d, 0.0)) + min(max(d.x, max(d.y, d.z)), 0.0) - cube.rounding;
+}
+
+float capsuleSDF(vec3 pos, Capsule capsule) {
+	pos = (capsule.inverseTransormation * vec4(pos, 1.0)).xyz;
+
+	vec3 pa = (pos - capsule.pos1), ba = capsule.pos2 - capsule.pos1;
+	float h = clamp( dot(pa,ba)/dot(ba,ba), 0.0, 1.0 );
+	return length( pa - ba*h ) - capsule.radius;
+}
+
+float primitiveDist(vec3 pos, Primitive primitive) {
+	// Too small on screen for its shape to show, the bounding sphere stands in for it
+	if (primitive.lodRadius < lodSize) return distance(pos, primitive.lodCenter) - primitive.lodRadius;
+	return primitiveSDF((primitive.inverseTransormation * vec4(pos, 1.0)).xyz, primitive.type, primitive.a, primitive.b);
+}
+
+vec3 getSphereNormal(vec3 pos, Sphere sphere) {
+	return normalize(pos - sphere.center);
+}
+
+vec3 getCubeNormal(vec3 pos, Cube cube) {
+	/*vec3 relativePos = pos - cube.center;
+    vec3 absRelativePos = abs(relativePos / cube.halfSize);
+
+    float maxAxis = max(absRelativePos.x, max(absRelativePos.y, absRelativePos.z));
+
+    if (maxAxis == absRelativePos.x) {
+        return vec3(sign(relativePos.x), 0.0, 0.0);
+    } else if (maxAxis == absRelativePos.y) {
+        return vec3(0.0, sign(relativePos.y), 0.0);
+    } else {
+        return vec3(0.0, 0.0, sign(relativePos.z));
+    }
+	return vec3(0.0);*/
+
+	vec3 normal = vec3(
+	(cubeSDF(pos + dx, cube) - cubeSDF(pos - dx, cube)),
+	(cubeSDF(pos + dy, cube) - cubeSDF(pos - dy, cube)),
+	(cubeSDF(pos + dz, cube) - cubeSDF(pos - dz, cube))
+);
+	return normalize(normal);
+}
+
+vec3 getCapsuleNormal(vec3 pos, Capsule capsule) {
+	vec3 normal = vec3(
+	(capsuleSDF(pos + dx, capsule) - capsuleSDF(pos - dx, capsule)),
+	(capsuleSDF(pos + dy, capsule) - capsuleSDF(pos - dy, capsule)),
+	(capsuleSDF(pos + dz, capsule) - capsuleSDF(pos - dz, capsule))
+);
+	return normalize(normal);
+}
+
+vec3 getPrimitiveNormal(vec3 pos, Primitive primitive) {
+	vec3 normal = vec3(
+	(primitiveDist(pos + dx, primitive) - primitiveDist(pos - dx, primitive)),
+	(primitiveDist(pos + dy, primitive) - primitiveDist(pos - dy, primitive)),
+	(primitiveDist(pos + dz, primitive) - primitiveDist(pos - dz, primitive))
+);
+	return normalize(normal);
+}
+
+vec3 getCsgNormal(vec3 pos, int shape) {
+	vec3 normal = vec3(
+	(csgDist(pos + dx, shape, MAX_DIST) - csgDist(pos - dx, shape, MAX_DIST)),
+	(csgDist(pos + dy, shape, MAX_DIST) - csgDist(pos - dy, shape, MAX_DIST)),
+	(csgDist(pos + dz, shape, MAX_DIST) - csgDist(pos - dz, shape, MAX_DIST))
+);
+	return normalize(normal);
+}
+
+// Lower bound on the distance to the static objects, -1 outside the baked volume
+float brickMapDist(vec3 pos) {
+	vec3 local = (pos - brickOrigin) / brickCellSize;
+	ivec3 cell = ivec3(floor(local));
+	if (any(lessThan(cell, ivec3(0))) || any(greaterThanEqual(cell, brickCells))) return -1.0;
+
+	int brick = texelFetch(brickIndex, cell, 0).r;
+	if (brick < 0) return texelFetch(brickCoarse, cell, 0).r;
+
+	// Bricks store the BRICK_RES + 1 corners of their voxels, so filtering never reads a neighbor brick.
+	// Interpolated distances are off by at most a voxel diagonal
+	ivec3 atlasBrick = ivec3(brick % brickAtlasBricks, (brick / brickAtlasBricks) % brickAtlasBricks, brick / (brickAtlasBricks * brickAtlasBricks));
+	vec3 texel = vec3(atlasBrick * (BRICK_RES + 1)) + 0.5 + fract(local) * BRICK_RES;
+	return texture(brickAtlas, texel / vec3(textureSize(brickAtlas, 0))).r - brickCellSize / BRICK_RES * sqrt(3.0);
+}
+
+// Objects analyticHit() intersects exactly, the distance field leaves them out when useAnalytic is set
+bool isAnalytic(Object obj) {
+	return obj.type == SPHERE || obj.type == CAPSULE || (obj.type == CUBE && cubes[obj.idx].rounding == 0.0);
+}
+
+// Spheres, cubes, capsules and primitives, the objects the brick map bakes
+void staticDist(vec3 pos, Object ignore, inout Intersect ans) {
+		for (int i = 0; !useAnalytic && i < sphereCount; ++i) {
+			if (ignore.type == SPHERE && ignore.idx == i) continue;
+
+			float dist = sphereSDF(pos, spheres[i]);
+
+			if (dist < ans.dist) {
+				ans.dist = dist;
+				ans.obj.idx = i;
+				ans.obj.type = SPHERE;
+			}
+		}
+		for (int i = 0; i < cubeCount; ++i) {
+			if (ignore.type == CUBE && ignore.idx == i) continue;
+			if (useAnalytic && cubes[i].rounding == 0.0) continue;
+
+			float dist = cubeSDF(pos, cubes[i]);
+
+			if (dist < ans.dist) {
+				ans.dist = dist;
+				ans.obj.idx = i;
+				ans.obj.type = CUBE;
+			}
+		}
+		for (int i = 0; !useAnalytic && i < capsuleCount; ++i) {
+			if (ignore.type == CAPSULE && ignore.idx == i) continue;
+
+			float dist = capsuleSDF(pos, capsules[i]);
+
+			if (dist < ans.dist) {
+				ans.dist = dist;
+				ans.obj.idx = i;
+				ans.obj.type = CAPSULE;
+			}
+		}
+		for (int i = 0; i < primitiveCount; ++i) {
+			if (ignore.type == PRIMITIVE && ignore.idx == i) continue;
+
+			float dist = primitiveDist(pos, primitives[i]);
+
+			if (dist < ans.dist) {
+				ans.dist = dist;
+				ans.obj.idx = i;
+				ans.obj.type = PRIMITIVE;
+			}
+		}
+}
+
+void testObject(int packed, vec3 pos, Object ignore, inout Intersect ans) {
+	Object obj = unpackObject(packed);
+	if (obj == ignore || (useAnalytic && isAnalytic(obj))) return;
+
+	float dist = MAX_DIST;
+	switch (obj.type) {
+		case SPHERE: dist = sphereSDF(pos, spheres[obj.idx]); break;
+		case CUBE: dist = cubeSDF(pos, cubes[obj.idx]); break;
+		case CAPSULE: dist = capsuleSDF(pos, capsules[obj.idx]); break;
+		case PRIMITIVE: dist = primitiveDist(pos, primitives[obj.idx]); break;
+	}
+
+	if (dist < ans.dist) {
+		ans.dist = dist;
+		ans.obj = obj;
+	}
+}
+
+// Same result as staticDist() within a cell of the objects, farther away the step is
+// only as long as the grid can prove is empty
+void gridDist(vec3 pos, Object ignore, inout Intersect ans) {
+	for (int i = 0; i < gridUnbounded; ++i) testObject(gridObjects[i], pos, ignore, ans);
+
+	vec3 local = (pos - gridOrigin) / gridCellSize;
+	ivec3 cell = ivec3(floor(local));
+	float bound;
+	if (any(lessThan(cell, ivec3(0))) || any(greaterThanEqual(cell, gridCells))) {
+		// The outer cells are always empty, so every object is a cell past the grid bounds
+		vec3 outside = max(max(-local, local - vec3(gridCells)), 0.0);
+		bound = (length(outside) + 1.0) * gridCellSize;
+	}
+	else {
+		GridCell data = gridCellData[cell.x + gridCells.x * (cell.y + gridCells.y * cell.z)];
+		// Objects left out of a listed cell are at least a cell away
+		bound = data.count > 0 ? gridCellSize : data.empty;
+		for (int i = data.start; i < data.start + data.count; ++i) testObject(gridObjects[i], pos, ignore, ans);
+	}
+
+	if (bound < ans.dist) {
+		ans.dist = bound;
+		ans.obj = Object(NONE, 0);
+	}
+}
+
+#ifdef PRIMARY_RAYS
+// Only valid along rays inside the frustum of primaryTile, objects culled from it can't be hit there
+// and the step can't reach them either
+void tileDist(vec3 pos, Object ignore, inout Intersect ans) {
+	for (int i = 0; i < cullUnbounded; ++i) testObject(cullObjects[i], pos, ignore, ans);
+
+	CullTile tile = cullTiles[primaryTile];
+	for (int i = tile.start; i < tile.start + tile.count; ++i) testObject(cullObjects[i], pos, ignore, ans);
+}
+#endif
+
+// Light proxies are not part of the distance field, see lightProxies().
+// ignore is skipped so rays leaving a surface don't hit it again, pass NONE to test everything
+Intersect sceneDist(vec3 pos, vec3 direction, Object ignore) {
+	Intersect ans = {MAX_DIST, {NONE, 0}};
+	lodSize = lodPixels * pixelFootprint(pos);
+		// Away from the static objects the brick map gives a safe step for all of them at once
+		float baked = useBrickMap ? brickMapDist(pos) : -1.0;
+		if (baked > brickBand) ans.dist = min(baked, MAX_DIST);
+#ifdef PRIMARY_RAYS
+		else if (primaryTile >= 0) tileDist(pos, ignore, ans);
+#endif
+		else if (useGrid) gridDist(pos, ignore, ans);
+		else staticDist(pos, ignore, ans);
+
+		for (int i = 0; i < csgCount; ++i) {
+			if (ignore.type == CSG && ignore.idx == i) continue;
+
+			// Shapes farther than the current closest object return early with their bounds distance
+			float dist = csgDist(pos, i, ans.dist);
+
+			if (dist < ans.dist) {
+				ans.dist = dist;
+				ans.obj.idx = i;
+				ans.obj.type = CSG;
+			}
+		}
+	return ans;
+}
+
+// Analytic ray-sphere test against the point light proxies, done once per ray
+// instead of adding a sphere per light to every sceneDist() evaluation
+Intersect lightProxies(vec3 origin, vec3 dir, float maxDist) {
+	Intersect ans = {maxDist, {NONE, 0}};
+	if (!showLights) return ans;
+
+	for (int i = 0; i < lightCount; ++i) {
+		vec3 oc = origin - pointLights[i].position;
+		float b = dot(oc, dir);
+		float c = dot(oc, oc) - LIGHT_RADIUS * LIGHT_RADIUS;
+		float h = b * b - c;
+		if (h < 0.0) continue;
+
+		float t = -b - sqrt(h);
+		if (t > 0.0 && t < ans.dist) {
+			ans.dist = t;
+			ans.obj.idx = i;
+			ans.obj.type = LIGHT;
+		}
+	}
+	return ans;
+}
+
+// Closed form ray intersections, -1 on a miss and 0 when the ray starts inside.
+// dir is unit length and the transforms are rigid, so distances are the same in object space
+float sphereHit(vec3 origin, vec3 dir, vec3 center, float radius) {
+	vec3 oc = origin - center;
+	float b = dot(oc, dir);
+	float c = dot(oc, oc) - radius * radius;
+	if (c < 0.0) return 0.0;
+	float h = b * b - c;
+	if (h < 0.0 || b > 0.0) return -1.0;
+	return -b - sqrt(h);
+}
+
+float cubeIntersect(vec3 origin, vec3 dir, Cube cube) {
+	vec3 o = (cube.inverseTransormation * vec4(origin, 1.0)).xyz;
+	vec3 d = (cube.inverseTransormation * vec4(dir, 0.0)).xyz;
+
+	vec3 inverse = 1.0 / d;
+	vec3 t0 = (-cube.halfSize - o) * inverse;
+	vec3 t1 = (cube.halfSize - o) * inverse;
+	vec3 near = min(t0, t1);
+	vec3 far = max(t0, t1);
+	float enter = max(max(near.x, near.y), near.z);
+	float exit = min(min(far.x, far.y), far.z);
+	if (enter > exit || exit < 0.0) return -1.0;
+	return max(enter, 0.0);
+}
+
+float capsuleIntersect(vec3 origin, vec3 dir, Capsule capsule) {
+	vec3 o = (capsule.inverseTransormation * vec4(origin, 1.0)).xyz;
+	vec3 d = (capsule.inverseTransormation * vec4(dir, 0.0)).xyz;
+
+	vec3 ba = capsule.pos2 - capsule.pos1;
+	vec3 oa = o - capsule.pos1;
+	float baba = dot(ba, ba);
+	float baoa = dot(ba, oa);
+	if (length(oa - ba * clamp(baoa / baba, 0.0, 1.0)) < capsule.radius) return 0.0;
+
+	// Infinite cylinder around the segment, the capsule is inside it
+	float bard = dot(ba, d);
+	float a = baba - bard * bard;
+	float b = baba * dot(d, oa) - baoa * bard;
+	float c = baba * dot(oa, oa) - baoa * baoa - capsule.radius * capsule.radius * baba;
+	float h = b * b - a * c;
+	if (h < 0.0) return -1.0;
+	if (a > 1e-6) {
+		float t = (-b - sqrt(h)) / a;
+		float y = baoa + t * bard;
+		if (y > 0.0 && y < baba) return t >= 0.0 ? t : -1.0;
+	}
+
+	// Entering through a cap, the caps are inside the capsule so the closer sphere hit is the entry
+	float t1 = sphereHit(o, d, capsule.pos1, capsule.radius);
+	float t2 = sphereHit(o, d, capsule.pos2, capsule.radius);
+	if (t1 < 0.0) return t2;
+	if (t2 < 0.0) return t1;
+	return min(t1, t2);
+}
+
+// Closest sphere, sharp cube or capsule closer than maxDist, dist is how far along the ray it is.
+// They are all convex, so a ray leaving ignore can't hit it again
+Intersect analyticHit(vec3 origin, vec3 dir, float maxDist, Object ignore) {
+	Intersect ans = {maxDist, {NONE, 0}};
+
+	for (int i = 0; i < sphereCount; ++i) {
+		if (ignore.type == SPHERE && ignore.idx == i) continue;
+		float t = sphereHit(origin, dir, spheres[i].center, spheres[i].radius);
+		if (t >= 0.0 && t < ans.dist) ans = Intersect(t, Object(SPHERE, i));
+	}
+	for (int i = 0; i < cubeCount; ++i) {
+		if (ignore.type == CUBE && ignore.idx == i) continue;
+		if (cubes[i].rounding != 0.0) continue;
+		float t = cubeIntersect(origin, dir, cubes[i]);
+		if (t >= 0.0 && t < ans.dist) ans = Intersect(t, Object(CUBE, i));
+	}
+	for (int i = 0; i < capsuleCount; ++i) {
+		if (ignore.type == CAPSULE && ignore.idx == i) continue;
+		float t = capsuleIntersect(origin, dir, capsules[i]);
+		if (t >= 0.0 && t < ans.dist) ans = Intersect(t, Object(CAPSULE, i));
+	}
+	return ans;
+}
+
+// Sphere traces from pos until a surface, a light proxy or the step budget is hit.
+// On a surface hit pos is left on it, otherwise the returned type is LIGHT or NONE (see stepsExhausted).
+Intersect march(inout vec3 pos, vec3 dir, Object ignore) {
+	stepsExhausted = false;
+	vec3 origin = pos;
+	Intersect proxy = lightProxies(origin, dir, MAX_DIST);
+
+	// Rays missing the scene box, like the sky, only hit the light proxies
+	vec2 clip = sceneClip(origin, dir);
+	float end = min(proxy.dist, clip.y);
+	if (clip.x >= end) return proxy;
+
+	// The exact hit, when there is one, is where the march can stop looking for something closer
+	Intersect nearest = proxy;
+	if (useAnalytic) {
+		Intersect exact = analyticHit(origin, dir, end, ignore);
+		if (exact.obj.type != NONE) {
+			nearest = exact;
+			end = exact.dist;
+		}
+	}
+	pos = origin + dir * clip.x;
+
+	while (length(pos - origin) < end) {
+		if (marchSteps >= stepBudget) {
+			stepsExhausted = true;
+			return Intersect(MAX_DIST, Object(NONE, 0));
+		}
+		++marchSteps;
+
+		Intersect intersect = sceneDist(pos, dir, ignore);
+
+		// Bounds from the brick map or the grid have no object and are never hits
+		if (intersect.obj.type != NONE && intersect.dist < hitEpsilon(pos)) return intersect;
+
+		pos += dir * intersect.dist;
+	}
+
+	if (nearest.obj.type != LIGHT && nearest.obj.type != NONE) pos = origin + dir * nearest.dist;
+	return nearest;
+}
+
+// march() for the camera ray through pixel, on the objects culled for its tile when culling is on
+// and the pass defines PRIMARY_RAYS
+Intersect marchPrimary(inout vec3 pos, vec3 dir, ivec2 pixel) {
+#ifdef PRIMARY_RAYS
+	if (useTileCulling) {
+		ivec2 tile = pixel / cullTileSize;
+		primaryTile = tile.x + tile.y * cullTilesX;
+	}
+	Intersect intersect = march(pos, dir, Object(NONE, 0));
+	primaryTile = -1;
+	return intersect;
+#else
+	return march(pos, dir, Object(NONE, 0));
+#endif
+}
+
+void surface(Intersect intersect, vec3 pos, out vec3 normal, out vec3 color, out float reflection) {
+	switch (intersect.obj.type) {
+		case SPHERE:
+			normal = getSphereNormal(pos, spheres[intersect.obj.idx]);
+			color = spheres[intersect.obj.idx].color;
+			reflection = spheres[intersect.obj.idx].reflection;
+			return;
+		case CUBE:
+			normal = getCubeNormal(pos, cubes[intersect.obj.idx]);
+			color = cubes[intersect.obj.idx].color;
+			reflection = cubes[intersect.obj.idx].reflection;
+			return;
+		case CAPSULE:
+			normal = getCapsuleNormal(pos, capsules[intersect.obj.idx]);
+			color = capsules[intersect.obj.idx].color;
+			reflection = capsules[intersect.obj.idx].reflection;
+			return;
+		case PRIMITIVE:
+			normal = getPrimitiveNormal(pos, primitives[intersect.obj.idx]);
+			color = primitives[intersect.obj.idx].color;
+			reflection = primitives[intersect.obj.idx].reflection;
+			return;
+		case CSG:
+			normal = getCsgNormal(pos, intersect.obj.idx);
+			color = csgShapes[intersect.obj.idx].color;
+			reflection = csgShapes[intersect.obj.idx].reflection;
+			return;
+	}
+
+	normal = vec3(0.0);
+	color = vec3(0.0);
+	reflection = 0.0;
+}
+
+vec3 shade(Intersect intersect, vec3 pos, bool shadows, out vec3 normal, out float reflection) {
+	vec3 color;
+	surface(intersect, pos, normal, color, reflection);
+	return calculateLight(pos, normal, color, intersect.obj, shadows);
+}
+
+// Iterative reflections: each bounce keeps (1 - reflection) of its own color and passes
+// the rest on. Stops at maxBounces, past lodShadeDistance, when the remaining energy drops below
+// minReflectance or when the shared step budget runs out; the last surface then keeps all of its energy.
+vec3 getColor(Intersect intersect, vec3 pos, vec3 dir) {
+	vec3 result = vec3(0.0);
+	float energy = 1.0;
+
+	for (int bounce = 0; bounce <= maxBounces; ++bounce) {
+		// Distant hits are only a few pixels of color, shadows and reflections would not show
+		bool distant = distance(pos, position) > lodShadeDistance;
+		vec3 normal;
+		float reflection;
+		vec3 color = shade(intersect, pos, !distant && (bounce == 0 || !cheapBounceLighting), normal, reflection);
+
+		if (distant || reflection == 0.0 || bounce >= maxBounces || energy * reflection < minReflectance)
+			return result + energy * color;
+
+		result += energy * (1.0 - reflection) * color;
+		energy *= reflection;
+
+		dir = reflect(dir, normal);
+		intersect = march(pos, dir, intersect.obj);
+
+		if (intersect.obj.type == LIGHT) return result + energy * pointLights[intersect.obj.idx].color;
+		if (intersect.obj.type == NONE) return stepsExhausted ? result + energy * color : result;
+	}
+
+	return result;
+}
+
+vec3 rayMarch(vec3 pos, ivec2 pixel) {
+	vec3 direction = getRayDirection(vec2(pixel) + 0.5);
+	Intersect intersect = marchPrimary(pos, direction, pixel);
+
+	if (intersect.obj.type == LIGHT) return pointLights[intersect.obj.idx].color;
+	if (intersect.obj.type == NONE) return vec3(0.0);
+
+	return getColor(intersect, pos, direction);
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+// Shared by the reduced resolution shading and upsampling passes
+
+#include "RayMarching.glsl"
+
+layout (rgba32f, binding = 1) uniform readonly image2D gPosition;
+layout (r32i, binding = 2) uniform readonly iimage2D gObject;
+
+// Shading is done once per shadingScale x shadingScale block of pixels
+uniform int shadingScale;
+
+// Full resolution pixel whose hit a low resolution pixel is shaded with
+ivec2 samplePixel(ivec2 low, ivec2 size) {
+	return min(low * shadingScale + shadingScale / 2, size - 1);
+}
+
+vec3 shadePixel(ivec2 pixel) {
+	Object obj = unpackObject(imageLoad(gObject, pixel).r);
+
+	if (obj.type == NONE) return vec3(0.0);
+	if (obj.type == LIGHT) return pointLights[obj.idx].color;
+
+	marchSteps = 0;
+	vec3 pos = imageLoad(gPosition, pixel).xyz;
+	return getColor(Intersect(0.0, obj), pos, getRayDirection(vec2(pixel) + 0.5));
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+// Reprojection into the previous frame, shared by the temporal passes
+
+#include "RayMarching.glsl"
+
+uniform bool historyValid; // False on the first frame of a mode or after a resize
+
+// Inverse of getRayDirection() with the previous camera: the pixel coordinates
+// a world position had last frame, or -1 when it was behind the camera
+vec2 reproject(vec3 worldPos) {
+	vec3 view = lastViewMatrix * (worldPos - lastPosition);
+	if (view.z >= 0.0) return vec2(-1.0);
+
+	vec2 aspectRatio = vec2(iResolution.x / iResolution.y, 1.0) * 0.5f;
+	vec2 uv = view.xy / -view.z / aspectRatio;
+	return (uv + 1.0) * 0.5 * iResolution;
+}
+
+bool onScreen(vec2 fragCoord) {
+	return all(greaterThanEqual(fragCoord, vec2(0.0))) && all(lessThan(fragCoord, iResolution));
+}
+
+// Hit distance of a ray's result, used to rebuild its world position
+float hitDistance(Intersect intersect, vec3 pos) {
+	if (intersect.obj.type == NONE) return MAX_DIST;
+	if (intersect.obj.type == LIGHT) return intersect.dist;
+	return distance(pos, position);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+// Ray queues and hit shading shared by the wavefront kernels. Instead of one kernel
+// following every secondary ray, each pass appends the rays it spawns to a compacted
+// queue in an SSBO, and the next pass only launches threads for queued rays.
+
+#include "RayMarching.glsl"
+
+#define QUEUE_GROUP_SIZE 64
+// Colors are accumulated per pixel with integer atomics in fixed point
+#define ACCUM_SCALE 4096.0
+
+struct ShadowRay {
+	vec4 origin; // w: distance to the light
+	vec3 dir;
+	int pixel;
+	vec3 contribution; // Light added to the pixel if the ray is unblocked
+	int object; // Packed, see packObject()
+};
+
+struct ReflectionRay {
+	vec4 origin; // w: remaining energy
+	vec4 dir;
+	ivec4 info; // x: pixel index, y: object type, z: object index, w: march steps used so far
+};
+
+// The count is followed by the indirect dispatch arguments, bumped every QUEUE_GROUP_SIZE rays
+layout (std430, binding = 0) buffer Accumulation { uint accum[]; };
+layout (std430, binding = 1) buffer ShadowQueue { uint shadowCount; uint shadowGroups[3]; ShadowRay shadowRays[]; };
+// The primary pass only pushes reflections, leaving this out keeps it at 16 blocks with the tile lists
+#ifndef PRIMARY_RAYS
+layout (std430, binding = 2) buffer ReflectionInQueue { uint reflectionInCount; uint reflectionInGroups[3]; ReflectionRay reflectionsIn[]; };
+#endif
+layout (std430, binding = 3) buffer ReflectionOutQueue { uint reflectionOutCount; uint reflectionOutGroups[3]; ReflectionRay reflectionsOut[]; };
+
+uniform int shadowCapacity;
+uniform int reflectionCapacity;
+uniform int bounce;
+
+void addColor(int pixel, vec3 color) {
+	uvec3 value = uvec3(max(color, 0.0) * ACCUM_SCALE + 0.5);
+
+	if (value.r > 0u) atomicAdd(accum[pixel * 3 + 0], value.r);
+	if (value.g > 0u) atomicAdd(accum[pixel * 3 + 1], value.g);
+	if (value.b > 0u) atomicAdd(accum[pixel * 3 + 2], value.b);
+}
+
+void pushShadowRay(vec3 origin, vec3 dir, float maxDist, vec3 contribution, int pixel, Object obj) {
+	uint i = atomicAdd(shadowCount, 1u);
+	if (i % QUEUE_GROUP_SIZE == 0u) atomicAdd(shadowGroups[0], 1u);
+	if (i >= uint(shadowCapacity)) return;
+
+	shadowRays[i].origin = vec4(origin, maxDist);
+	shadowRays[i].dir = dir;
+	shadowRays[i].pixel = pixel;
+	shadowRays[i].contribution = contribution;
+	shadowRays[i].object = packObject(obj);
+}
+
+void pushReflectionRay(vec3 origin, vec3 dir, float energy, int pixel, Object obj, int steps) {
+	uint i = atomicAdd(reflectionOutCount, 1u);
+	if (i % QUEUE_GROUP_SIZE == 0u) atomicAdd(reflectionOutGroups[0], 1u);
+	if (i >= uint(reflectionCapacity)) return;
+
+	reflectionsOut[i].origin = vec4(origin, energy);
+	reflectionsOut[i].dir = vec4(dir, 0.0);
+	reflectionsOut[i].info = ivec4(pixel, obj.type, obj.idx, steps);
+}
+
+// Same result as getColor() for one bounce: ambient and unshadowed light go straight to
+// the pixel, shadowed light and the reflection are queued for the following passes
+void shadeHit(Intersect intersect, vec3 pos, vec3 dir, float energy, int pixel, int steps) {
+	vec3 normal, color;
+	float reflection;
+	surface(intersect, pos, normal, color, reflection);
+
+	bool distant = distance(pos, position) > lodShadeDistance;
+	float weight = energy;
+	if (!distant && reflection > 0.0 && bounce < maxBounces && energy * reflection >= minReflectance) {
+		weight = energy * (1.0 - reflection);
+		pushReflectionRay(pos, reflect(dir, normal), energy * reflection, pixel, intersect.obj, steps);
+	}
+
+	bool shadows = !distant && (bounce == 0 || !cheapBounceLighting);
+	vec3 lit = vec3(0.0);
+	vec3 ambient, direct;
+
+	dirLightTerms(dirLight, normal, inDir, color, ambient, direct);
+	lit += ambient;
+	if (!shadows) lit += direct;
+	else if (any(greaterThan(direct, vec3(0.0))))
+		pushShadowRay(pos, normalize(-dirLight.direction), MAX_SHADOW_DIST, weight * direct, pixel, intersect.obj);
+
+	for (int i = 0; i < lightCount; ++i) {
+		pointLightTerms(pointLights[i], normal, pos, inDir, color, ambient, direct);
+		lit += ambient;
+		if (!shadows) lit += direct;
+		else if (any(greaterThan(direct, vec3(0.0)))) {
+			vec3 toLight = pointLights[i].position - pos;
+			pushShadowRay(pos, normalize(toLight), length(toLight), weight * direct, pixel, intersect.obj);
+		}
+	}
+
+	addColor(pixel, weight * lit);
+}
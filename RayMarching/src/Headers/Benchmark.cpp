@@ -0,0 +1,103 @@
+#include "Benchmark.hpp"
+#include "IO/Input.hpp"
+
+GpuTimer::GpuTimer()
+{
+	glGenQueries(QUERY_COUNT, queries.data());
+}
+
+void GpuTimer::begin()
+{
+	glBeginQuery(GL_TIME_ELAPSED, queries[issued % QUERY_COUNT]);
+}
+
+bool GpuTimer::end()
+{
+	glEndQuery(GL_TIME_ELAPSED);
+	++issued;
+
+	if (issued < QUERY_COUNT) return false;
+
+	// The oldest query in the ring, issued QUERY_COUNT - 1 frames ago
+	unsigned int query = queries[issued % QUERY_COUNT];
+	GLint available = 0;
+	glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available) return false;
+
+	GLuint64 elapsed = 0;
+	glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+	ms = static_cast<float>(elapsed) / 1000000.0f;
+	return true;
+}
+
+void Benchmark::start(RenderSettings& settings, int framesPerMode)
+{
+	this->framesPerMode = framesPerMode;
+	previousMode = settings.mode;
+	previousLookup = settings.lookup;
+	running = true;
+	mode = 0;
+	lookup = 0;
+	frame = 0;
+	samples.clear();
+	settings.mode = static_cast<RenderMode>(mode);
+	settings.lookup = static_cast<SceneLookup>(lookup);
+}
+
+void Benchmark::begin()
+{
+	timer.begin();
+}
+
+bool Benchmark::end(RenderSettings& settings)
+{
+	if (!timer.end()) return false;
+	gpuMs = gpuMs == 0.0f ? timer.ms : gpuMs * 0.95f + timer.ms * 0.05f;
+
+	if (!running) return false;
+
+	// Skip the frames still in flight from the previous mode
+	if (++frame <= WARMUP_FRAMES) return false;
+	samples.push_back(timer.ms);
+	if ((int)samples.size() < framesPerMode) return false;
+
+	float sum = 0.0f;
+	float minimum = samples[0];
+	for (float sample : samples) {
+		sum += sample;
+		minimum = std::min(minimum, sample);
+	}
+	averages[lookup][mode] = sum / samples.size();
+	minimums[lookup][mode] = minimum;
+
+	samples.clear();
+	frame = 0;
+	gpuMs = 0.0f;
+
+	if (++mode == (int)RenderMode::Count) {
+		mode = 0;
+		++lookup;
+	}
+	if (lookup < (int)SceneLookup::Count) {
+		settings.mode = static_cast<RenderMode>(mode);
+		settings.lookup = static_cast<SceneLookup>(lookup);
+		return false;
+	}
+
+	running = false;
+	settings.mode = previousMode;
+	settings.lookup = previousLookup;
+	report();
+	return true;
+}
+
+void Benchmark::report() const
+{
+	std::cout << "Benchmark (" << SCR_WIDTH << "x" << SCR_HEIGHT << ", " << framesPerMode << " frames per mode)" << std::endl;
+	for (int l = 0; l < (int)SceneLookup::Count; ++l) {
+		std::cout << " " << SceneLookupNames[l] << " lookup" << std::endl;
+		for (int i = 0; i < (int)RenderMode::Count; ++i) {
+			std::cout << "  " << RenderModeNames[i] << ": avg " << averages[l][i] << " ms, min " << minimums[l][i] << " ms" << std::endl;
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <glad/glad.h>
+#include <array>
+#include <algorithm>
+#include <vector>
+#include <iostream>
+#include "RenderSettings.hpp"
+
+// Measures the GPU time between begin() and end(). Results are read a few frames
+// late so waiting on a query never stalls the pipeline.
+class GpuTimer {
+private:
+	static constexpr int QUERY_COUNT = 4;
+	std::array<unsigned int, QUERY_COUNT> queries{};
+	int issued = 0;
+
+public:
+	GpuTimer();
+
+	void begin();
+	// Returns true when an older query became available and 'ms' was updated
+	bool end();
+
+	float ms = 0.0f;
+};
+
+// Sweeps every render mode with every scene lookup over the same frames and prints the average GPU time of each
+class Benchmark {
+private:
+	static constexpr int WARMUP_FRAMES = 10;
+
+	GpuTimer timer;
+	int framesPerMode = 300;
+	int mode = 0;
+	int lookup = 0;
+	int frame = 0;
+	RenderMode previousMode = RenderMode::Fragment;
+	SceneLookup previousLookup = SceneLookup::Linear;
+	std::vector<float> samples;
+	// Indexed [lookup][mode]
+	std::array<std::array<float, (size_t)RenderMode::Count>, (size_t)SceneLookup::Count> averages{};
+	std::array<std::array<float, (size_t)RenderMode::Count>, (size_t)SceneLookup::Count> minimums{};
+
+public:
+	float gpuMs = 0.0f; // Smoothed GPU time of the current mode
+	bool running = false;
+
+public:
+	void start(RenderSettings& settings, int framesPerMode = 300);
+	void begin();
+	// Returns true on the frame a sweep finishes
+	bool end(RenderSettings& settings);
+
+private:
+	void report() const;
+};
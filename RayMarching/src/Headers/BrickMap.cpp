@@ -0,0 +1,136 @@
+#include "BrickMap.hpp"
+#include <iostream>
+#include <vector>
+
+// Binding of the BrickList block in BrickBake.comp
+constexpr unsigned int BrickListBinding = 13;
+
+static void createVolume(unsigned int& texture, GLenum format, glm::ivec3 size, GLenum filter)
+{
+	if (texture != 0) glDeleteTextures(1, &texture);
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_3D, texture);
+	glTexStorage3D(GL_TEXTURE_3D, 1, format, size.x, size.y, size.z);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+BrickMap::BrickMap(const std::string& shaderDir)
+	: bakeShader(shaderDir + "BrickBake.comp")
+{
+	glGenBuffers(1, &brickList);
+}
+
+BrickMap::~BrickMap()
+{
+	unsigned int textures[] = { coarseTexture, indexTexture, atlasTexture };
+	glDeleteTextures(3, textures);
+	glDeleteBuffers(1, &brickList);
+}
+
+void BrickMap::bake(Objects& objects)
+{
+	Bounds bounds = objects.staticBounds();
+	bounds.min = glm::max(bounds.min - glm::vec3(cellSize), glm::vec3(-maxExtent));
+	bounds.max = glm::min(bounds.max + glm::vec3(cellSize), glm::vec3(maxExtent));
+	glm::vec3 size = bounds.max - bounds.min;
+	if (!(size.x > 0.0f && size.y > 0.0f && size.z > 0.0f)) {
+		baked = false;
+		return;
+	}
+
+	float largest = glm::max(size.x, glm::max(size.y, size.z));
+	bakedCellSize = glm::max(cellSize, largest / MaxCells);
+	cells = glm::ivec3(glm::ceil(size / bakedCellSize));
+	origin = bounds.min;
+	int capacity = glm::min(cells.x * cells.y * cells.z, maxBricks);
+
+	createVolume(coarseTexture, GL_R32F, cells, GL_NEAREST);
+	createVolume(indexTexture, GL_R32I, cells, GL_NEAREST);
+
+	// Brick count, padded to 16 bytes, then one ivec4 per brick
+	std::vector<glm::ivec4> list(capacity + 1, glm::ivec4(0));
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, brickList);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, list.size() * sizeof(glm::ivec4), list.data(), GL_DYNAMIC_COPY);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BrickListBinding, brickList);
+
+	objects.upload();
+	bakeShader.use();
+	objects.update(bakeShader);
+	update(bakeShader, false);
+	bakeShader.setInt("brickCapacity", capacity);
+
+	// Coarse cells, the groups are (BrickRes + 1)^3 for the brick pass
+	constexpr int group = BrickRes + 1;
+	bakeShader.setInt("bakePass", 0);
+	glBindImageTexture(0, coarseTexture, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R32F);
+	glBindImageTexture(1, indexTexture, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R32I);
+	glDispatchCompute((cells.x + group - 1) / group, (cells.y + group - 1) / group, (cells.z + group - 1) / group);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+	// The atlas is sized from the bricks actually allocated, baking is rare enough for the stall
+	GLuint allocated = 0;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, brickList);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &allocated);
+	brickCount = glm::min(static_cast<int>(allocated), capacity);
+	if (static_cast<int>(allocated) > capacity)
+		std::cout << "Brick map full, " << allocated - capacity << " cells near surfaces are evaluated exactly" << std::endl;
+
+	atlasBricks = 1;
+	while (atlasBricks * atlasBricks * atlasBricks < brickCount) ++atlasBricks;
+	createVolume(atlasTexture, GL_R16F, glm::ivec3(atlasBricks * (BrickRes + 1)), GL_LINEAR);
+
+	if (brickCount > 0) {
+		bakeShader.setInt("bakePass", 1);
+		bakeShader.setInt("brickAtlasBricks", atlasBricks);
+		glBindImageTexture(2, atlasTexture, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R16F);
+		glDispatchCompute(glm::min(brickCount, 65535), (brickCount + 65534) / 65535, 1);
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	bakedSpheres = objects.spheres;
+	bakedCubes = objects.cubes;
+	bakedCapsules = objects.capsules;
+	bakedPrimitives = objects.primitives;
+	baked = true;
+}
+
+void BrickMap::validate(const Objects& objects)
+{
+	if (!baked) return;
+	if (objects.spheres == bakedSpheres && objects.cubes == bakedCubes
+		&& objects.capsules == bakedCapsules && objects.primitives == bakedPrimitives) return;
+
+	baked = false;
+	std::cout << "Objects changed since the brick map was baked, it is off until the next bake" << std::endl;
+}
+
+void BrickMap::update(Shader& shader, bool enabled) const
+{
+	shader.setBool("useBrickMap", enabled && baked);
+	shader.setVec3("brickOrigin", origin);
+	shader.setFloat("brickCellSize", bakedCellSize);
+	shader.setIVec3("brickCells", cells);
+	shader.setInt("brickAtlasBricks", atlasBricks);
+	shader.setFloat("brickBand", band());
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_3D, coarseTexture);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_3D, indexTexture);
+	glActiveTexture(GL_TEXTURE3);
+	glBindTexture(GL_TEXTURE_3D, atlasTexture);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+// Exact evaluation starts two voxel diagonals from a surface, the interpolated
+// distances are too loose closer than that and the march would crawl
+float BrickMap::band() const
+{
+	return 2.0f * bakedCellSize / BrickRes * 1.7320508f;
+}
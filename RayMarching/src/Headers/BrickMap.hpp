@@ -0,0 +1,59 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "Shaders/Shader.hpp"
+#include "Objects.hpp"
+
+// Sparse distance field of the static objects (spheres, cubes, capsules and primitives), baked on the GPU.
+// A coarse grid keeps a lower bound on the distance in every cell, and the cells near a surface get
+// a brick of BrickRes^3 voxels. Far from surfaces sceneDist() steps with the map, so the march cost
+// stops growing with the object count, and close to them it evaluates the objects exactly
+class BrickMap {
+public:
+	static constexpr int BrickRes = 8; // BRICK_RES in RayMarching.glsl
+	static constexpr int MaxCells = 256; // Along each axis, the cells grow past cellSize to stay under it
+
+	Shader bakeShader;
+
+	float cellSize = 1.0f;
+	float maxExtent = 100.0f; // The baked volume stops this far from the origin
+	int maxBricks = 32768; // Cells past it keep their coarse bound and are evaluated exactly
+
+	// Last bake
+	bool baked = false;
+	glm::vec3 origin = glm::vec3(0.0f);
+	glm::ivec3 cells = glm::ivec3(0);
+	float bakedCellSize = 1.0f;
+	int brickCount = 0;
+
+private:
+	unsigned int coarseTexture = 0;
+	unsigned int indexTexture = 0;
+	unsigned int atlasTexture = 0;
+	unsigned int brickList = 0;
+	int atlasBricks = 1;
+
+	// The objects as they were baked
+	std::vector<Sphere> bakedSpheres;
+	std::vector<Cube> bakedCubes;
+	std::vector<Capsule> bakedCapsules;
+	std::vector<Primitive> bakedPrimitives;
+
+public:
+	BrickMap(const std::string& shaderDir);
+	~BrickMap();
+	BrickMap(const BrickMap&) = delete;
+	BrickMap& operator=(const BrickMap&) = delete;
+
+	// Samples the objects where they are now, moving them needs another bake
+	void bake(Objects& objects);
+	// Drops the map once the objects differ from the baked ones, its distances would hide them
+	void validate(const Objects& objects);
+	// enabled is the user setting, the map is only used once something has been baked
+	void update(Shader& shader, bool enabled) const;
+
+private:
+	float band() const;
+};
@@ -1,44 +1,52 @@
 #include "Camera.hpp"
 
-Camera::Camera(GLFWwindow* window, Shader& shader)
+Camera::Camera()
 {
-    useCam = true;
-    shader.use();
-    this->update(window, shader, 0.0f);
-    useCam = false;
+    updateVectors();
+    this->setState(this->state());
 }
 
-void Camera::update(GLFWwindow* window, Shader& shader, float dt)
+void Camera::update(const Controls& controls, float dt)
 {
-    if (useCam) {
-        this->Yaw += xoffset * mouseSens;
-        this->Pitch += yoffset * mouseSens;
+    if (controls.enabled) {
+        this->Yaw += controls.look.x * mouseSens;
+        this->Pitch += controls.look.y * mouseSens;
 
-        if (Pitch < -89.0f) Pitch = -89.0f;
-        else if (Pitch > 89.0f) Pitch = 89.0f;
+        updateVectors();
 
-        front.x = cos(glm::radians(Yaw)) * cos(glm::radians(Pitch));
-        front.y = sin(glm::radians(Pitch));
-        front.z = sin(glm::radians(Yaw)) * cos(glm::radians(Pitch));
-        front = glm::normalize(front);
-        right = glm::normalize(glm::cross(front, WorldUp));
-
-        if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
-            this->move(Camera::FORWARD, dt);
-        if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)
-            this->move(Camera::BACKWARD, dt);
-        if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
-            this->move(Camera::LEFT, dt);
-        if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
-            this->move(Camera::RIGHT, dt);
+        if (controls.forward) this->move(Camera::FORWARD, dt);
+        if (controls.backward) this->move(Camera::BACKWARD, dt);
+        if (controls.left) this->move(Camera::LEFT, dt);
+        if (controls.right) this->move(Camera::RIGHT, dt);
     }
 
-    glm::mat3 viewMatrix = glm::lookAt(Position, Position + front, WorldUp);
+    viewMatrix = glm::lookAt(Position, Position + front, WorldUp);
+    viewPosition = Position;
+}
 
-    shader.setVec2("iResolution", SCR_WIDTH, SCR_HEIGHT);
-    shader.setMat3("viewMatrix", viewMatrix);
-    shader.setVec3("position", Position);
-    shader.setVec3("inDir", front);
+CameraState Camera::state() const
+{
+    return { Position, Yaw, Pitch, front };
+}
+
+void Camera::setState(const CameraState& state)
+{
+    Position = state.position;
+    Yaw = state.yaw;
+    Pitch = state.pitch;
+    // Kept as given, the GUI edits it directly
+    front = state.front;
+    right = glm::normalize(glm::cross(front, WorldUp));
+
+    viewMatrix = glm::lookAt(Position, Position + front, WorldUp);
+    viewPosition = Position;
+}
+
+void Camera::present(const CameraState& state)
+{
+    lastViewMatrix = viewMatrix;
+    lastPosition = viewPosition;
+    setState(state);
 }
 
 void Camera::move(Movement movement, float dt)
@@ -50,3 +58,23 @@ void Camera::move(Movement movement, float dt)
     if (movement == LEFT) Position -= right * velocity;
     if (movement == RIGHT) Position += right * velocity;
 }
+
+void Camera::setView(glm::vec3 position, float yaw, float pitch)
+{
+    Position = position;
+    Yaw = yaw;
+    Pitch = pitch;
+    updateVectors();
+}
+
+void Camera::updateVectors()
+{
+    if (Pitch < -89.0f) Pitch = -89.0f;
+    else if (Pitch > 89.0f) Pitch = 89.0f;
+
+    front.x = cos(glm::radians(Yaw)) * cos(glm::radians(Pitch));
+    front.y = sin(glm::radians(Pitch));
+    front.z = sin(glm::radians(Yaw)) * cos(glm::radians(Pitch));
+    front = glm::normalize(front);
+    right = glm::normalize(glm::cross(front, WorldUp));
+}
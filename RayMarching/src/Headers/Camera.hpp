@@ -4,9 +4,19 @@
 #include <GLFW/glfw3.h>
 // GLM
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 // Other
 #include "IO/Input.hpp"
-#include "Shaders/Shader.hpp"
+
+// Everything the view is built from, what the simulation thread hands to the renderer
+struct CameraState {
+    glm::vec3 position;
+    float yaw;
+    float pitch;
+    glm::vec3 front;
+
+    bool operator==(const CameraState&) const = default;
+};
 
 class Camera {
 private:
@@ -28,8 +38,34 @@ public:
     float mouseSens = 0.08f;
     const float MovementSpeed = 8.0f;
 
+    glm::mat3 viewMatrix = glm::mat3(1.0f);
+    // View of the previous frame, for temporal reprojection
+    glm::mat3 lastViewMatrix = glm::mat3(1.0f);
+    glm::vec3 lastPosition = { 0.0f, 0.0f, 0.0f };
+    // Position viewMatrix was built at, sent to the shaders by FrameUniforms
+    glm::vec3 viewPosition = { 0.0f, 0.0f, 0.0f };
+
+    // What moves the camera during one update, sampled from the keyboard and mouse
+    struct Controls {
+        bool enabled = false;
+        glm::vec2 look = { 0.0f, 0.0f }; // Mouse offset in pixels
+        bool forward = false;
+        bool backward = false;
+        bool left = false;
+        bool right = false;
+    };
+
 public:
-    Camera(GLFWwindow* window, Shader& shader);
-    void update(GLFWwindow* window, Shader& shader, float dt);
+    Camera();
+    void update(const Controls& controls, float dt);
     void move(Movement movement, float dt);
+    CameraState state() const;
+    void setState(const CameraState& state);
+    // Shows a new view, the one shown until now becomes the last view
+    void present(const CameraState& state);
+    // Places the camera without going through the mouse, e.g. when loading a scene
+    void setView(glm::vec3 position, float yaw, float pitch);
+
+private:
+    void updateVectors();
 };
\ No newline at end of file
@@ -0,0 +1,596 @@
+#include "Csg.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+
+#pragma region Shape
+int CsgShape::leaf(Primitive primitive)
+{
+	CsgNode node;
+	node.primitive = primitive;
+	nodes.push_back(node);
+	return static_cast<int>(nodes.size()) - 1;
+}
+
+int CsgShape::combine(Csg::Op op, int a, int b, float blend)
+{
+	CsgNode node;
+	node.op = op;
+	node.blend = blend;
+	node.children = { a, b };
+	nodes.push_back(node);
+	return static_cast<int>(nodes.size()) - 1;
+}
+
+int CsgShape::bend(int child, float curvature, glm::vec3 pivot)
+{
+	CsgNode node;
+	node.op = Csg::Op::Bend;
+	node.blend = curvature;
+	node.pivot = pivot;
+	node.children = { child };
+	nodes.push_back(node);
+	return static_cast<int>(nodes.size()) - 1;
+}
+
+int CsgShape::repeat(int child, glm::vec3 spacing, glm::ivec3 limit, float jitter, glm::vec3 pivot)
+{
+	CsgNode node;
+	node.op = Csg::Op::Repeat;
+	node.blend = jitter;
+	node.pivot = pivot;
+	node.spacing = spacing;
+	node.limit = limit;
+	node.children = { child };
+	nodes.push_back(node);
+	return static_cast<int>(nodes.size()) - 1;
+}
+
+float CsgShape::distance(glm::vec3 pos) const
+{
+	return root < 0 ? INFINITY : distance(root, pos);
+}
+
+float CsgShape::distance(int index, glm::vec3 pos) const
+{
+	const CsgNode& node = nodes[index];
+	if (node.op == Csg::Op::Leaf) return Primitives::distance(node.primitive, pos);
+	if (node.op == Csg::Op::Bend) return distance(node.children[0], Csg::bendPoint(pos - node.pivot, node.blend) + node.pivot);
+	if (node.op == Csg::Op::Repeat) {
+		float d = INFINITY;
+		for (int i = 0; i < 8; ++i) {
+			if (Csg::repeatSkips(node.spacing, i)) continue;
+			float scale;
+			glm::vec3 q = Csg::repeatPoint(pos, node.pivot, node.spacing, node.limit, node.blend, i, scale);
+			d = glm::min(d, distance(node.children[0], q) * scale);
+		}
+		return d;
+	}
+
+	float d = distance(node.children[0], pos);
+	for (int i = 1; i < node.children.size(); ++i) {
+		float c = distance(node.children[i], pos);
+		if (node.op == Csg::Op::Union) d = Csg::smoothMin(d, c, node.blend);
+		else if (node.op == Csg::Op::Intersect) d = Csg::smoothMax(d, c, node.blend);
+		else d = Csg::smoothMax(d, -c, node.blend);
+	}
+	return d;
+}
+#pragma endregion
+
+// Same formulas as getBend(), csgRepeatPoint(), csgHash(), smoothMin() and smoothMax() in RayMarching.glsl
+glm::vec3 Csg::bendPoint(glm::vec3 p, float curvature)
+{
+	float c = std::cos(curvature * p.x);
+	float s = std::sin(curvature * p.x);
+	return glm::vec3(c * p.x - s * p.y, s * p.x + c * p.y, p.z);
+}
+
+glm::vec3 Csg::repeatPoint(glm::vec3 p, glm::vec3 pivot, glm::vec3 spacing, glm::ivec3 limit, float jitter, int iteration, float& scale)
+{
+	glm::vec3 local = p - pivot;
+	glm::ivec3 cell(0);
+	for (int axis = 0; axis < 3; ++axis) {
+		if (spacing[axis] <= 0.0f) continue;
+		float x = local[axis] / spacing[axis];
+		float id = std::floor(x + 0.5f);
+		if (iteration >> axis & 1) id += x > id ? 1.0f : x < id ? -1.0f : 0.0f;
+		if (limit[axis] > 0) id = glm::clamp(id, static_cast<float>(-limit[axis]), static_cast<float>(limit[axis]));
+		cell[axis] = static_cast<int>(id);
+	}
+	scale = 1.0f - jitter * hash(cell);
+	return (local - spacing * glm::vec3(cell)) / scale + pivot;
+}
+
+bool Csg::repeatSkips(glm::vec3 spacing, int iteration)
+{
+	for (int axis = 0; axis < 3; ++axis)
+		if ((iteration >> axis & 1) && spacing[axis] <= 0.0f) return true;
+	return false;
+}
+
+float Csg::hash(glm::ivec3 cell)
+{
+	uint32_t h = (static_cast<uint32_t>(cell.x) * 73856093u) ^ (static_cast<uint32_t>(cell.y) * 19349663u) ^ (static_cast<uint32_t>(cell.z) * 83492791u);
+	h = (h ^ (h >> 16)) * 0x45d9f3bu;
+	h ^= h >> 16;
+	return static_cast<float>(h & 0xffffu) / 65535.0f;
+}
+
+float Csg::smoothMin(float a, float b, float k)
+{
+	if (k <= 0.0f) return glm::min(a, b);
+	float h = glm::max(k - glm::abs(a - b), 0.0f) / k;
+	return glm::min(a, b) - h * h * k * 0.25f;
+}
+
+float Csg::smoothMax(float a, float b, float k)
+{
+	return -smoothMin(-a, -b, k);
+}
+
+#pragma region Compiler
+namespace {
+	struct Compiler {
+		Csg::Program& program;
+		const CsgShape& shape;
+		Csg::CompiledShape& out;
+
+		int add(Csg::CompiledNode node)
+		{
+			out.nodes.push_back(std::move(node));
+			return static_cast<int>(out.nodes.size()) - 1;
+		}
+
+		// Children of a hard op that can be merged into their parent
+		void collect(Csg::Op op, int index, std::vector<int>& children)
+		{
+			const CsgNode& node = shape.nodes[index];
+			if (node.op == op && node.blend == 0.0f) {
+				for (int child : node.children) collect(op, child, children);
+			}
+			else children.push_back(flatten(index));
+		}
+
+		// (a - b) - c and a - (b u c) both become a - b - c
+		void collectSubtract(int index, std::vector<int>& children)
+		{
+			const CsgNode& node = shape.nodes[index];
+			const CsgNode& first = shape.nodes[node.children[0]];
+			if (first.op == Csg::Op::Subtract && first.blend == 0.0f) collectSubtract(node.children[0], children);
+			else children.push_back(flatten(node.children[0]));
+
+			for (int i = 1; i < node.children.size(); ++i) collect(Csg::Op::Union, node.children[i], children);
+		}
+
+		int flatten(int index)
+		{
+			const CsgNode& node = shape.nodes[index];
+			switch (node.op) {
+			case Csg::Op::Leaf: {
+				Csg::CompiledNode leaf{ Csg::Op::Leaf, 0.0f };
+				leaf.source = index;
+				leaf.leafSlot = program.leafCount++;
+				return add(leaf);
+			}
+			case Csg::Op::Bend: {
+				if (node.blend == 0.0f) return flatten(node.children[0]);
+				int child = flatten(node.children[0]);
+				return add({ Csg::Op::Bend, node.blend, { child }, node.pivot });
+			}
+			case Csg::Op::Repeat: {
+				if (node.spacing == glm::vec3(0.0f)) return flatten(node.children[0]);
+				int child = flatten(node.children[0]);
+				return add({ Csg::Op::Repeat, node.blend, { child }, node.pivot, node.spacing, node.limit });
+			}
+			default: {
+				std::vector<int> children;
+				if (node.op == Csg::Op::Subtract) {
+					if (node.blend == 0.0f) collectSubtract(index, children);
+					else for (int child : node.children) children.push_back(flatten(child));
+				}
+				else if (node.blend == 0.0f) {
+					for (int child : node.children) collect(node.op, child, children);
+				}
+				else for (int child : node.children) children.push_back(flatten(child));
+
+				if (children.size() == 1) return children[0];
+				return add({ node.op, node.blend, children });
+			}
+			}
+		}
+	};
+
+	std::string number(float value)
+	{
+		char buffer[32];
+		std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+		std::string text = buffer;
+		if (text.find_first_of(".eEn") == std::string::npos) text += ".0";
+		return text;
+	}
+
+	std::string vec3(glm::vec3 value)
+	{
+		return "vec3(" + number(value.x) + ", " + number(value.y) + ", " + number(value.z) + ")";
+	}
+
+	struct Emitter {
+		const Csg::CompiledShape& shape;
+		std::string code;
+		int counter = 0;
+
+		std::string line(int depth, const std::string& text)
+		{
+			return std::string(depth, '\t') + text + "\n";
+		}
+
+		// Appends the code for a node and returns the variable holding its distance
+		std::string emit(int index, const std::string& p, int depth)
+		{
+			const Csg::CompiledNode& node = shape.nodes[index];
+			std::string d = "d" + std::to_string(counter++);
+
+			if (node.op == Csg::Op::Leaf) {
+				code += line(depth, "float " + d + " = primitiveDist(" + p + ", csgLeaves[" + std::to_string(node.leafSlot) + "]);");
+				return d;
+			}
+			if (node.op == Csg::Op::Bend) {
+				std::string q = "p" + std::to_string(counter++);
+				std::string pivot = vec3(node.pivot);
+				code += line(depth, "vec3 " + q + " = getBend(" + p + " - " + pivot + ", " + number(node.blend) + ") + " + pivot + ";");
+				return emit(node.children[0], q, depth);
+			}
+			if (node.op == Csg::Op::Repeat) {
+				// The child is emitted once, inside a loop over the nearest cells
+				std::string i = "i" + std::to_string(counter);
+				std::string q = "p" + std::to_string(counter);
+				std::string scale = "s" + std::to_string(counter++);
+				std::string spacing = vec3(node.spacing);
+				code += line(depth, "float " + d + " = MAX_DIST;");
+				code += line(depth, "for (int " + i + " = 0; " + i + " < 8; ++" + i + ") {");
+				code += line(depth + 1, "if (csgRepeatSkips(" + spacing + ", " + i + ")) continue;");
+				code += line(depth + 1, "float " + scale + ";");
+				code += line(depth + 1, "vec3 " + q + " = csgRepeatPoint(" + p + ", " + vec3(node.pivot) + ", " + spacing + ", ivec3(" +
+					std::to_string(node.limit.x) + ", " + std::to_string(node.limit.y) + ", " + std::to_string(node.limit.z) + "), " +
+					number(node.blend) + ", " + i + ", " + scale + ");");
+				std::string c = emit(node.children[0], q, depth + 1);
+				code += line(depth + 1, d + " = min(" + d + ", " + c + " * " + scale + ");");
+				code += line(depth, "}");
+				return d;
+			}
+
+			std::string first = emitLod(node.children[0], p, depth);
+			code += line(depth, "float " + d + " = " + first + ";");
+			std::string k = number(node.blend);
+
+			for (int i = 1; i < node.children.size(); ++i) {
+				const Csg::CompiledNode& child = shape.nodes[node.children[i]];
+				// A child whose bounds are far enough can't change the result. The box distance is 0
+				// inside the box, where it says nothing about the child, so the tests never skip there
+				bool guarded = child.boundsSlot >= 0 && !(node.op == Csg::Op::Intersect && node.blend > 0.0f);
+				int inner = depth;
+				if (guarded) {
+					std::string box = "csgBoxDist(" + p + ", " + std::to_string(child.boundsSlot) + ")";
+					std::string test =
+						node.op == Csg::Op::Union ? box + " < max(" + d + " + " + k + ", eplison)" :
+						node.op == Csg::Op::Subtract ? box + " < max(" + k + " - " + d + ", eplison)" :
+						box + " < max(" + d + ", eplison)";
+					code += line(depth, "if (" + test + ") {");
+					inner = depth + 1;
+				}
+
+				std::string c = node.op == Csg::Op::Subtract ? emit(node.children[i], p, inner) : emitLod(node.children[i], p, inner);
+				std::string combined =
+					node.op == Csg::Op::Union ? "smoothMin(" + d + ", " + c + ", " + k + ")" :
+					node.op == Csg::Op::Intersect ? "smoothMax(" + d + ", " + c + ", " + k + ")" :
+					"smoothMax(" + d + ", -" + c + ", " + k + ")";
+				if (node.blend == 0.0f) {
+					combined = node.op == Csg::Op::Union ? "min(" + d + ", " + c + ")" :
+						node.op == Csg::Op::Intersect ? "max(" + d + ", " + c + ")" :
+						"max(" + d + ", -" + c + ")";
+				}
+				code += line(inner, d + " = " + combined + ";");
+
+				if (guarded) {
+					// For a hard intersection the box distance is still a lower bound on the child
+					if (node.op == Csg::Op::Intersect) code += line(depth, "} else " + d + " = max(" + d + ", csgBoxDist(" + p + ", " + std::to_string(child.boundsSlot) + "));");
+					else code += line(depth, "}");
+				}
+			}
+			return d;
+		}
+
+		// Children too small on screen are replaced by their box, see csgLod(). The box is a lower bound,
+		// so subtracted children keep their shape, a box there would overestimate the distance
+		std::string emitLod(int index, const std::string& p, int depth)
+		{
+			const Csg::CompiledNode& node = shape.nodes[index];
+			if (node.op == Csg::Op::Leaf || node.boundsSlot < 0) return emit(index, p, depth);
+
+			std::string d = "d" + std::to_string(counter++);
+			code += line(depth, "float " + d + " = csgLod(" + p + ", " + std::to_string(node.boundsSlot) + ");");
+			code += line(depth, "if (" + d + " < 0.0) {");
+			std::string c = emit(index, p, depth + 1);
+			code += line(depth + 1, d + " = " + c + ";");
+			code += line(depth, "}");
+			return d;
+		}
+	};
+
+	void assignBounds(Csg::Program& program, Csg::CompiledShape& shape)
+	{
+		for (int i = 0; i < shape.nodes.size(); ++i)
+			if (shape.nodes[i].op != Csg::Op::Leaf || i == shape.root) shape.nodes[i].boundsSlot = program.boundsCount++;
+	}
+
+	Bounds nodeBounds(const Csg::CompiledShape& compiled, const CsgShape& shape, int index, std::vector<Bounds>& slots)
+	{
+		const Csg::CompiledNode& node = compiled.nodes[index];
+		Bounds bounds;
+
+		if (node.op == Csg::Op::Leaf) {
+			bounds = Primitives::worldBounds(shape.nodes[node.source].primitive);
+		}
+		else if (node.op == Csg::Op::Bend) {
+			// Bending rotates xy around the pivot's z axis, so only the distance to that axis is kept
+			Bounds child = nodeBounds(compiled, shape, node.children[0], slots);
+			glm::vec3 low = child.min - node.pivot;
+			glm::vec3 high = child.max - node.pivot;
+			glm::vec2 far = glm::max(glm::abs(glm::vec2(low.x, low.y)), glm::abs(glm::vec2(high.x, high.y)));
+			float radius = glm::length(far);
+			bounds = { node.pivot + glm::vec3(-radius, -radius, low.z), node.pivot + glm::vec3(radius, radius, high.z) };
+		}
+		else if (node.op == Csg::Op::Repeat) {
+			bounds = nodeBounds(compiled, shape, node.children[0], slots);
+			for (int axis = 0; axis < 3; ++axis) {
+				if (node.spacing[axis] <= 0.0f) continue;
+				// Repeated forever the bounds are infinite, Objects::pack() keeps such shapes out of the scene box
+				float reach = node.limit[axis] > 0 ? node.spacing[axis] * node.limit[axis] : INFINITY;
+				bounds.min[axis] -= reach;
+				bounds.max[axis] += reach;
+			}
+		}
+		else {
+			bounds = nodeBounds(compiled, shape, node.children[0], slots);
+			for (int i = 1; i < node.children.size(); ++i) {
+				Bounds child = nodeBounds(compiled, shape, node.children[i], slots);
+				if (node.op == Csg::Op::Union) {
+					bounds.min = glm::min(bounds.min, child.min);
+					bounds.max = glm::max(bounds.max, child.max);
+				}
+				else if (node.op == Csg::Op::Intersect) {
+					bounds.min = glm::max(bounds.min, child.min);
+					bounds.max = glm::min(bounds.max, child.max);
+				}
+			}
+			// A smooth union can bulge out by up to a quarter of the blend radius
+			if (node.op == Csg::Op::Union) {
+				bounds.min -= glm::vec3(node.blend * 0.25f);
+				bounds.max += glm::vec3(node.blend * 0.25f);
+			}
+		}
+
+		if (node.boundsSlot >= 0) slots[node.boundsSlot] = bounds;
+		return bounds;
+	}
+}
+
+Csg::Program Csg::compile(const std::vector<CsgShape>& shapes)
+{
+	Program program;
+	std::string functions = "// Generated by Csg::compile() from the CSG shapes in Objects\n\n";
+	std::string dispatch = "float csgSDF(vec3 p, int shape, float limit) {\n\tswitch (shape) {\n";
+
+	for (int s = 0; s < shapes.size(); ++s) {
+		CompiledShape& compiled = program.shapes.emplace_back();
+		if (shapes[s].root >= 0 && !shapes[s].dynamic) {
+			Compiler compiler{ program, shapes[s], compiled };
+			compiled.root = compiler.flatten(shapes[s].root);
+			assignBounds(program, compiled);
+		}
+
+		std::string name = "csgShape" + std::to_string(s);
+		functions += "float " + name + "(vec3 p, float limit) {\n";
+		if (compiled.root < 0) functions += "\treturn MAX_DIST;\n";
+		else {
+			// Nothing in the shape can be closer than its bounds
+			functions += "\tfloat bounds = csgBoxDist(p, " + std::to_string(compiled.nodes[compiled.root].boundsSlot) + ");\n";
+			functions += "\tif (bounds > limit) return bounds;\n\n";
+			Emitter emitter{ compiled };
+			std::string result = emitter.emit(compiled.root, "p", 1);
+			functions += emitter.code + "\treturn " + result + ";\n";
+		}
+		functions += "}\n\n";
+		dispatch += "\t\tcase " + std::to_string(s) + ": return " + name + "(p, limit);\n";
+	}
+
+	program.glsl = functions + dispatch + "\t}\n\treturn MAX_DIST;\n}\n";
+	return program;
+}
+
+std::vector<Bounds> Csg::computeBounds(const Program& program, const std::vector<CsgShape>& shapes)
+{
+	std::vector<Bounds> slots(program.boundsCount);
+	for (int s = 0; s < program.shapes.size() && s < shapes.size(); ++s)
+		if (program.shapes[s].root >= 0) nodeBounds(program.shapes[s], shapes[s], program.shapes[s].root, slots);
+	return slots;
+}
+
+std::vector<const Primitive*> Csg::leaves(const Program& program, const std::vector<CsgShape>& shapes)
+{
+	std::vector<const Primitive*> slots(program.leafCount);
+	for (int s = 0; s < program.shapes.size() && s < shapes.size(); ++s)
+		for (const CompiledNode& node : program.shapes[s].nodes)
+			if (node.op == Op::Leaf) slots[node.leafSlot] = &shapes[s].nodes[node.source].primitive;
+	return slots;
+}
+#pragma endregion
+
+#pragma region Bytecode
+namespace {
+	struct Assembler {
+		const Csg::CompiledShape& shape;
+		std::vector<Csg::Instruction>& code;
+		int depth = 0;
+		int maxDepth = 0;
+		int transforms = 0;
+		int maxTransforms = 0;
+		int repeats = 0;
+		int maxRepeats = 0;
+
+		// Post order, so every op finds its operands on top of the stack
+		void emit(int index)
+		{
+			const Csg::CompiledNode& node = shape.nodes[index];
+			switch (node.op) {
+			case Csg::Op::Leaf:
+				code.push_back({ Csg::Opcode::Leaf, node.leafSlot });
+				maxDepth = glm::max(maxDepth, ++depth);
+				return;
+			case Csg::Op::Bend:
+				code.push_back({ Csg::Opcode::PushBend, -1, node.blend, node.pivot });
+				maxTransforms = glm::max(maxTransforms, ++transforms);
+				emit(node.children[0]);
+				code.push_back({ Csg::Opcode::Pop });
+				--transforms;
+				return;
+			case Csg::Op::Repeat: {
+				// The running minimum stays on the stack while the child is evaluated
+				int start = static_cast<int>(code.size());
+				code.push_back({ Csg::Opcode::Repeat, -1, node.blend, node.pivot, node.spacing, node.limit });
+				maxDepth = glm::max(maxDepth, ++depth);
+				maxRepeats = glm::max(maxRepeats, ++repeats);
+				emit(node.children[0]);
+				code.push_back({ Csg::Opcode::EndRepeat, start });
+				--depth;
+				--repeats;
+				return;
+			}
+			default: {
+				Csg::Opcode op = node.op == Csg::Op::Union ? Csg::Opcode::Union :
+					node.op == Csg::Op::Intersect ? Csg::Opcode::Intersect : Csg::Opcode::Subtract;
+				emit(node.children[0]);
+				for (int i = 1; i < node.children.size(); ++i) {
+					emit(node.children[i]);
+					code.push_back({ op, -1, node.blend });
+					--depth;
+				}
+			}
+			}
+		}
+	};
+}
+
+Csg::Bytecode Csg::assemble(const std::vector<CsgShape>& shapes, const Program& program)
+{
+	Bytecode bytecode;
+	bytecode.leafOffset = program.leafCount;
+	bytecode.boundsOffset = program.boundsCount;
+
+	// Flattened the same way as compiled shapes, leaf slots continue after the compiled ones
+	Program scratch;
+	scratch.leafCount = program.leafCount;
+	std::vector<Bounds> unused;
+
+	for (int s = 0; s < shapes.size(); ++s) {
+		Bytecode::Range& range = bytecode.shapes.emplace_back();
+		bool compiled = s < program.shapes.size() && program.shapes[s].root >= 0;
+		if (compiled || shapes[s].root < 0) continue;
+
+		CompiledShape flat;
+		Compiler compiler{ scratch, shapes[s], flat };
+		flat.root = compiler.flatten(shapes[s].root);
+
+		int start = static_cast<int>(bytecode.code.size());
+		Assembler assembler{ flat, bytecode.code };
+		assembler.emit(flat.root);
+		if (assembler.maxDepth > StackSize || assembler.maxTransforms > TransformStackSize || assembler.maxRepeats > RepeatStackSize) {
+			std::cerr << "ERROR::CSG::SHAPE_TOO_DEEP " << s << std::endl;
+			bytecode.code.resize(start);
+			continue;
+		}
+
+		range.start = start;
+		range.end = static_cast<int>(bytecode.code.size());
+		range.boundsSlot = bytecode.boundsOffset + static_cast<int>(bytecode.bounds.size());
+		bytecode.bounds.push_back(nodeBounds(flat, shapes[s], flat.root, unused));
+
+		bytecode.leaves.resize(scratch.leafCount - bytecode.leafOffset);
+		for (const CompiledNode& node : flat.nodes)
+			if (node.op == Op::Leaf) bytecode.leaves[node.leafSlot - bytecode.leafOffset] = &shapes[s].nodes[node.source].primitive;
+	}
+	return bytecode;
+}
+
+float Csg::run(const Bytecode& bytecode, int shape, glm::vec3 pos)
+{
+	const Bytecode::Range& range = bytecode.shapes[shape];
+	if (range.start < 0) return INFINITY;
+
+	float stack[StackSize];
+	glm::vec3 transforms[TransformStackSize];
+	glm::vec3 repeatOrigins[RepeatStackSize];
+	float repeatScales[RepeatStackSize];
+	int repeatIterations[RepeatStackSize];
+	int top = 0;
+	int saved = 0;
+	int loops = 0;
+
+	for (int pc = range.start; pc < range.end; ++pc) {
+		const Instruction& instruction = bytecode.code[pc];
+		switch (instruction.op) {
+		case Opcode::Leaf:
+			stack[top++] = Primitives::distance(*bytecode.leaves[instruction.arg - bytecode.leafOffset], pos);
+			break;
+		case Opcode::Union:
+			--top;
+			stack[top - 1] = smoothMin(stack[top - 1], stack[top], instruction.blend);
+			break;
+		case Opcode::Subtract:
+			--top;
+			stack[top - 1] = smoothMax(stack[top - 1], -stack[top], instruction.blend);
+			break;
+		case Opcode::Intersect:
+			--top;
+			stack[top - 1] = smoothMax(stack[top - 1], stack[top], instruction.blend);
+			break;
+		case Opcode::PushBend:
+			transforms[saved++] = pos;
+			pos = bendPoint(pos - instruction.pivot, instruction.blend) + instruction.pivot;
+			break;
+		case Opcode::Pop:
+			pos = transforms[--saved];
+			break;
+		case Opcode::Repeat:
+			repeatOrigins[loops] = pos;
+			repeatIterations[loops] = 0;
+			stack[top++] = INFINITY;
+			pos = repeatPoint(pos, instruction.pivot, instruction.spacing, instruction.limit, instruction.blend, 0, repeatScales[loops]);
+			++loops;
+			break;
+		case Opcode::EndRepeat: {
+			const Instruction& repeat = bytecode.code[instruction.arg];
+			int loop = loops - 1;
+			--top;
+			stack[top - 1] = glm::min(stack[top - 1], stack[top] * repeatScales[loop]);
+
+			int next = repeatIterations[loop] + 1;
+			while (next < 8 && repeatSkips(repeat.spacing, next)) ++next;
+			if (next < 8) {
+				repeatIterations[loop] = next;
+				pos = repeatPoint(repeatOrigins[loop], repeat.pivot, repeat.spacing, repeat.limit, repeat.blend, next, repeatScales[loop]);
+				pc = instruction.arg;
+			}
+			else {
+				pos = repeatOrigins[loop];
+				--loops;
+			}
+			break;
+		}
+		}
+	}
+	return stack[0];
+}
+#pragma endregion
@@ -0,0 +1,151 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "Primitives.hpp"
+
+// Constructive solid geometry over registry primitives.
+// A CsgShape is built in C++ and compiled once into a straight-line GLSL function (Csg.glsl).
+// The tree structure and blend radii are baked into that code, while the leaf primitives
+// and the bounds of every node are uploaded each frame, so leaves can still be edited live.
+// Dynamic shapes skip the compiler and run as bytecode instead, so their structure can change too
+namespace Csg {
+	enum class Op {
+		Leaf,
+		Union,
+		Subtract,	// first child minus all the others
+		Intersect,
+		Bend,		// domain op, bends its child around the z axis through the pivot
+		Repeat		// domain op, copies its child on a grid of cells centered on the pivot
+	};
+}
+
+struct CsgNode {
+	Csg::Op op = Csg::Op::Leaf;
+	Primitive primitive;
+	// Smoothing radius of the boolean ops (0 is a hard edge), curvature of Bend,
+	// for Repeat how much the copies shrink at random (0 to 1)
+	float blend = 0.0f;
+	glm::vec3 pivot = glm::vec3(0.0f);
+	// Repeat: cell size (0 leaves an axis alone) and cells on each side of the pivot (0 repeats forever)
+	glm::vec3 spacing = glm::vec3(0.0f);
+	glm::ivec3 limit = glm::ivec3(0);
+	std::vector<int> children;
+};
+
+class CsgShape {
+public:
+	std::vector<CsgNode> nodes;
+	int root = -1; // Set by the caller once the tree is built, -1 for an empty shape
+	glm::vec3 color = glm::vec3(1.0f);
+	float reflection = 0.0f;
+	// Interpreted from bytecode, edits to the tree cost an upload instead of a shader compile
+	bool dynamic = false;
+
+	// Each returns the new node and leaves root alone
+	int leaf(Primitive primitive);
+	int combine(Csg::Op op, int a, int b, float blend = 0.0f);
+	int bend(int child, float curvature, glm::vec3 pivot = glm::vec3(0.0f));
+	// The child has to fit in its cell, only the two nearest cells on each axis are evaluated
+	int repeat(int child, glm::vec3 spacing, glm::ivec3 limit = glm::ivec3(0), float jitter = 0.0f, glm::vec3 pivot = glm::vec3(0.0f));
+
+	// Same distance as the compiled GLSL
+	float distance(glm::vec3 pos) const;
+
+private:
+	float distance(int node, glm::vec3 pos) const;
+};
+
+namespace Csg {
+	// A shape after flattening and constant folding, nodes refer back to the source leaves
+	struct CompiledNode {
+		Op op;
+		float blend;
+		std::vector<int> children;
+		glm::vec3 pivot = glm::vec3(0.0f);
+		glm::vec3 spacing = glm::vec3(0.0f);
+		glm::ivec3 limit = glm::ivec3(0);
+		// Leaf: node index in the source shape, and slot in the leaf buffer
+		int source = -1;
+		int leafSlot = -1;
+		// Slot in the bounds buffer, -1 for nodes whose bounds are never tested
+		int boundsSlot = -1;
+	};
+
+	struct CompiledShape {
+		std::vector<CompiledNode> nodes;
+		int root = -1;
+	};
+
+	struct Program {
+		std::vector<CompiledShape> shapes;
+		int leafCount = 0;
+		int boundsCount = 0;
+		std::string glsl;
+	};
+
+	// Flattens nested unions/intersections, drops no-op bends and zero blends,
+	// and emits csgSDF(p, shape, limit) with a bounds test in front of every subtree.
+	// Dynamic shapes get an empty function
+	Program compile(const std::vector<CsgShape>& shapes);
+
+	// Conservative world space bounds of every compiled node, in bounds slot order
+	std::vector<Bounds> computeBounds(const Program& program, const std::vector<CsgShape>& shapes);
+	// Leaves in leaf slot order
+	std::vector<const Primitive*> leaves(const Program& program, const std::vector<CsgShape>& shapes);
+
+	// Stack machine run by csgRun() in RayMarching.glsl, the values match the CSG_* defines there
+	enum class Opcode {
+		Leaf,		// pushes the distance to a leaf
+		Union,		// pops b and a, pushes the combination
+		Subtract,
+		Intersect,
+		PushBend,	// saves the point and bends it
+		Pop,		// restores the last saved point
+		Repeat,		// saves the point, pushes the running minimum and moves into the first cell
+		EndRepeat	// folds the child into the minimum, then jumps back to arg for the next cell
+	};
+
+	constexpr int StackSize = 16;		// CSG_STACK_SIZE
+	constexpr int TransformStackSize = 8;	// CSG_TRANSFORM_STACK
+	constexpr int RepeatStackSize = 2;	// CSG_REPEAT_STACK
+
+	struct Instruction {
+		Opcode op;
+		int arg = -1;	// slot in the leaf buffer, or the Repeat an EndRepeat jumps back to
+		float blend = 0.0f;
+		glm::vec3 pivot = glm::vec3(0.0f);
+		glm::vec3 spacing = glm::vec3(0.0f);
+		glm::ivec3 limit = glm::ivec3(0);
+	};
+
+	struct Bytecode {
+		struct Range {
+			int start = -1;		// -1 for shapes that are compiled, empty or too deep
+			int end = -1;
+			int boundsSlot = -1;
+		};
+
+		std::vector<Instruction> code;
+		std::vector<Range> shapes;
+		// Leaves and root bounds of the interpreted shapes, their slots continue after the compiled ones
+		int leafOffset = 0;
+		int boundsOffset = 0;
+		std::vector<const Primitive*> leaves;
+		std::vector<Bounds> bounds;
+	};
+
+	// Assembles every shape the program has no code for, cheap enough to redo each frame
+	Bytecode assemble(const std::vector<CsgShape>& shapes, const Program& program);
+	// CPU version of csgRun()
+	float run(const Bytecode& bytecode, int shape, glm::vec3 pos);
+
+	glm::vec3 bendPoint(glm::vec3 p, float curvature);
+	// Repetition, same as csgRepeatPoint() and csgRepeatSkips(). Iterations 0 to 7 step towards
+	// the neighbor cells on the axes of their bits, scale is how much the copy in that cell shrinks
+	glm::vec3 repeatPoint(glm::vec3 p, glm::vec3 pivot, glm::vec3 spacing, glm::ivec3 limit, float jitter, int iteration, float& scale);
+	bool repeatSkips(glm::vec3 spacing, int iteration);
+	float hash(glm::ivec3 cell);
+	float smoothMin(float a, float b, float k);
+	float smoothMax(float a, float b, float k);
+}
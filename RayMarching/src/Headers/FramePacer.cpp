@@ -0,0 +1,104 @@
+#include "FramePacer.hpp"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+FramePacer::~FramePacer()
+{
+	for (Frame& frame : inFlight) {
+		glDeleteSync(frame.fence);
+		freeQueries.push_back(frame.timestamp);
+	}
+	if (!freeQueries.empty()) glDeleteQueries(static_cast<GLsizei>(freeQueries.size()), freeQueries.data());
+}
+
+void FramePacer::beginFrame()
+{
+	applyVsync();
+
+	// Frames already done are only collected, then the oldest are waited for until few enough are left
+	retire(false);
+	while (static_cast<int>(inFlight.size()) >= std::max(maxFramesInFlight, 1)) retire(true);
+
+	waitForCap();
+
+	Clock::time_point now = Clock::now();
+	frameMs = std::chrono::duration<float, std::milli>(now - lastBegin).count();
+	lastBegin = now;
+}
+
+void FramePacer::inputSampled()
+{
+	glGetInteger64v(GL_TIMESTAMP, &inputTime);
+}
+
+void FramePacer::endFrame()
+{
+	unsigned int timestamp = 0;
+	if (freeQueries.empty()) glGenQueries(1, &timestamp);
+	else {
+		timestamp = freeQueries.back();
+		freeQueries.pop_back();
+	}
+	glQueryCounter(timestamp, GL_TIMESTAMP);
+	inFlight.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), timestamp, inputTime });
+}
+
+void FramePacer::applyVsync()
+{
+	if (vsync == appliedVsync) return;
+	appliedVsync = vsync;
+
+	int interval = vsync == VSync::Off ? 0 : 1;
+	if (vsync == VSync::Adaptive) {
+		// Negative intervals are adaptive, only allowed with the swap control tear extension
+		if (glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+			interval = -1;
+		else
+			std::cout << "No adaptive vsync, using regular vsync" << std::endl;
+	}
+	glfwSwapInterval(interval);
+}
+
+// Pops the oldest frame once its fence passed, blocking for it when wait is set
+void FramePacer::retire(bool wait)
+{
+	while (!inFlight.empty()) {
+		Frame& frame = inFlight.front();
+		GLenum status = glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 1000000000 : 0);
+		if (status == GL_TIMEOUT_EXPIRED) {
+			if (wait) continue;
+			return;
+		}
+
+		// The fence passed, so the timestamp is there without waiting
+		GLuint64 done = 0;
+		glGetQueryObjectui64v(frame.timestamp, GL_QUERY_RESULT, &done);
+		float latency = static_cast<float>(static_cast<GLint64>(done) - frame.input) / 1000000.0f;
+		latencyMs = latencyMs == 0.0f ? latency : latencyMs * 0.95f + latency * 0.05f;
+		freeQueries.push_back(frame.timestamp);
+		glDeleteSync(frame.fence);
+		inFlight.pop_front();
+		if (wait) return;
+	}
+}
+
+void FramePacer::waitForCap()
+{
+	if (fpsCap <= 0.0f) {
+		nextFrame = Clock::now();
+		return;
+	}
+
+	// Frames are due at fixed intervals, a late one moves the schedule instead of rushing the next
+	Clock::time_point now = Clock::now();
+	nextFrame += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(1.0f / fpsCap));
+	if (nextFrame < now) {
+		nextFrame = now;
+		return;
+	}
+
+	if (nextFrame - now > SpinTime) std::this_thread::sleep_until(nextFrame - SpinTime);
+	while (Clock::now() < nextFrame) std::this_thread::yield();
+}
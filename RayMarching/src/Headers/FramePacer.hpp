@@ -0,0 +1,67 @@
+#pragma once
+#include <glad/glad.h>
+#include <chrono>
+#include <deque>
+#include <vector>
+
+enum class VSync {
+	Off,
+	On,
+	Adaptive, // Waits for vblank unless the frame is late, then tears instead of waiting for the next one
+	Count
+};
+
+inline const char* VSyncNames[] = { "Off", "On", "Adaptive" };
+
+// Decides when a frame starts. beginFrame() waits for the frame rate cap (sleeping, then spinning for
+// the last stretch the OS sleep is too coarse for) and for the GPU to be at most maxFramesInFlight
+// frames behind, so input sampled right after it is as fresh as possible when the frame is drawn.
+// The latency reported is from the input sample to the GPU finishing the frame, both read on the GPU
+// clock (a timestamp query after the swap), a lower bound of input to photon
+class FramePacer {
+public:
+	VSync vsync = VSync::On;
+	float fpsCap = 0.0f; // 0 for no cap
+	int maxFramesInFlight = 2;
+
+	// Measured
+	float latencyMs = 0.0f; // Input to GPU done, averaged
+	float frameMs = 0.0f;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	// Below this the wait spins instead of sleeping
+	static constexpr std::chrono::microseconds SpinTime{ 2000 };
+
+	struct Frame {
+		GLsync fence;
+		unsigned int timestamp; // Query written when the GPU is done with the frame
+		GLint64 input; // GPU time of the input sample
+	};
+	std::deque<Frame> inFlight;
+	std::vector<unsigned int> freeQueries;
+
+	VSync appliedVsync = VSync::Count;
+	Clock::time_point nextFrame = Clock::now();
+	Clock::time_point lastBegin = Clock::now();
+	GLint64 inputTime = 0;
+
+public:
+	FramePacer() = default;
+	~FramePacer();
+	FramePacer(const FramePacer&) = delete;
+	FramePacer& operator=(const FramePacer&) = delete;
+
+	// Before polling input
+	void beginFrame();
+	// Right after the input of the frame was read
+	void inputSampled();
+	// After the swap
+	void endFrame();
+
+private:
+	void applyVsync();
+	void retire(bool wait);
+	void waitForCap();
+};
@@ -0,0 +1,81 @@
+#include "FrameUniforms.hpp"
+
+// std140 layout of the Frame block in RayMarching.glsl, a mat3 is three vec4 columns
+namespace {
+	struct GPUMat3 {
+		glm::vec4 columns[3];
+	};
+
+	struct GPUDirLight {
+		glm::vec3 direction;
+		float padding0;
+		glm::vec3 ambient;
+		float padding1;
+		glm::vec3 diffuse;
+		float padding2;
+		glm::vec3 specular;
+		float padding3;
+		glm::vec3 color;
+		float padding4;
+	};
+
+	struct GPUFrame {
+		GPUMat3 viewMatrix;
+		GPUMat3 lastViewMatrix;
+		glm::vec3 position;
+		float time;
+		glm::vec3 lastPosition;
+		int frameIndex;
+		glm::vec3 inDir;
+		float maxDist;
+		glm::vec2 resolution;
+		float maxShadowDist;
+		float surfaceEpsilon;
+		GPUDirLight dirLight;
+	};
+
+	static_assert(sizeof(GPUFrame) == 240);
+}
+
+static GPUMat3 toStd140(const glm::mat3& matrix)
+{
+	return { { glm::vec4(matrix[0], 0.0f), glm::vec4(matrix[1], 0.0f), glm::vec4(matrix[2], 0.0f) } };
+}
+
+FrameUniforms::FrameUniforms()
+{
+	glGenBuffers(1, &UBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(GPUFrame), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, Binding, UBO);
+}
+
+FrameUniforms::~FrameUniforms()
+{
+	glDeleteBuffers(1, &UBO);
+}
+
+void FrameUniforms::update(const Camera& camera, const LightingSystem& lightSys, const RenderSettings& settings, float time, int frameIndex)
+{
+	const DirectionalLight& light = lightSys.dirLight;
+
+	GPUFrame frame;
+	frame.viewMatrix = toStd140(camera.viewMatrix);
+	frame.lastViewMatrix = toStd140(camera.lastViewMatrix);
+	frame.position = camera.viewPosition;
+	frame.time = time;
+	frame.lastPosition = camera.lastPosition;
+	frame.frameIndex = frameIndex;
+	frame.inDir = camera.front;
+	frame.maxDist = settings.maxDist;
+	frame.resolution = glm::vec2(SCR_WIDTH, SCR_HEIGHT);
+	frame.maxShadowDist = settings.maxShadowDist;
+	frame.surfaceEpsilon = settings.surfaceEpsilon;
+	frame.dirLight = { light.direction, 0.0f, light.ambient, 0.0f, light.diffuse, 0.0f,
+		light.specular, 0.0f, light.color, 0.0f };
+
+	glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(GPUFrame), &frame);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <glad/glad.h>
+#include "Camera.hpp"
+#include "LightingSystem.hpp"
+#include "RenderSettings.hpp"
+
+// Uniform buffer holding what every pass of a frame shares: camera, resolution, time, frame index,
+// directional light and the march distances (the Frame block in RayMarching.glsl). It is written
+// with a single glBufferSubData per frame and stays bound, so no program sets these on its own
+class FrameUniforms {
+private:
+	static constexpr unsigned int Binding = 0;
+	unsigned int UBO = 0;
+
+public:
+	FrameUniforms();
+	~FrameUniforms();
+	FrameUniforms(const FrameUniforms&) = delete;
+	FrameUniforms& operator=(const FrameUniforms&) = delete;
+
+	void update(const Camera& camera, const LightingSystem& lightSys, const RenderSettings& settings, float time, int frameIndex);
+};
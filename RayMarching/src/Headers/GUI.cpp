@@ -1,7 +1,10 @@
 #include "GUI.hpp"
+#include <cstdio>
 
-GUI::GUI(GLFWwindow* window, Camera& camera, Objects& objects, LightingSystem& lightSys) : objects(objects), lightSys(lightSys), camera(camera)
+GUI::GUI(GLFWwindow* window, Camera& camera, Objects& objects, LightingSystem& lightSys, RenderSettings& settings, Benchmark& benchmark, BrickMap& brickMap, UniformGrid& grid, TileCulling& culling, FramePacer& pacer, const std::string& scenePath) : objects(objects), lightSys(lightSys), camera(camera), settings(settings), benchmark(benchmark), brickMap(brickMap), grid(grid), culling(culling), pacer(pacer)
 {
+	if (!scenePath.empty()) std::snprintf(this->scenePath, sizeof(this->scenePath), "%s", scenePath.c_str());
+
 	IMGUI_CHECKVERSION();
 	ImGui::CreateContext();
 	ImGuiIO& io = ImGui::GetIO(); (void)io;
@@ -23,6 +26,8 @@ void GUI::update()
 	ImGui::ShowMetricsWindow();
     lightAndCamWindow();
     myObjects();
+    renderWindow();
+    sceneWindow();
 }
 
 void GUI::render()
@@ -65,6 +70,9 @@ void GUI::lighting()
     ImGui::EndChild();
 
     ImGui::SeparatorText("Point Lights");
+    ImGui::Checkbox("Show Light Proxies", &lightSys.showLightProxies);
+    // Only the point lights go through the simulation, the directional light is read every frame
+    bool edited = false;
     ImGui::BeginChild("Point Lights");
     for (int i = 0; i < lightSys.pointLights.size(); ++i) {
         if (i > 0) ImGui::Separator();
@@ -77,18 +85,19 @@ void GUI::lighting()
         glm::vec3& specular = pointLight.specular;
         glm::vec3& color = pointLight.color;
 
-        ImGui::DragFloat3("Position", &position[0], 0.05f);
-        ImGui::ColorEdit3("Ambient", &ambient[0]);
-        ImGui::ColorEdit3("Diffuse", &diffuse[0]);
-        ImGui::ColorEdit3("Specular", &specular[0]);
-        ImGui::ColorEdit3("Color", &color[0]);
-        ImGui::DragFloat("Constant", &pointLight.constant, 0.05f);
-        ImGui::DragFloat("Linear", &pointLight.linear, 0.05f);
-        ImGui::DragFloat("Quadratic", &pointLight.quadratic, 0.05f);
+        edited |= ImGui::DragFloat3("Position", &position[0], 0.05f);
+        edited |= ImGui::ColorEdit3("Ambient", &ambient[0]);
+        edited |= ImGui::ColorEdit3("Diffuse", &diffuse[0]);
+        edited |= ImGui::ColorEdit3("Specular", &specular[0]);
+        edited |= ImGui::ColorEdit3("Color", &color[0]);
+        edited |= ImGui::DragFloat("Constant", &pointLight.constant, 0.05f);
+        edited |= ImGui::DragFloat("Linear", &pointLight.linear, 0.05f);
+        edited |= ImGui::DragFloat("Quadratic", &pointLight.quadratic, 0.05f);
 
         ImGui::EndChild();
     }
     ImGui::EndChild();
+    if (edited) ++sceneEdit;
 }
 
 void GUI::cameraWindow()
@@ -107,6 +116,7 @@ void GUI::cameraWindow()
 void GUI::myObjects()
 {
     ImGui::Begin("Objects");
+    bool edited = false;
 
     ImGui::SeparatorText("Spheres");
     ImGui::BeginChild("Spheres", { 0, 95 * (float)objects.spheres.size()});
@@ -118,10 +128,10 @@ void GUI::myObjects()
         glm::vec3& position = sphere.center;
         glm::vec3& color = sphere.color;
 
-        ImGui::DragFloat3("Position", &position[0], 0.05f);
-        ImGui::ColorEdit3("Color", &color[0]);
-        ImGui::DragFloat("Radius", &sphere.radius, 0.05f, 0.1f);
-        ImGui::DragFloat("Reflection", &sphere.reflection, 0.01f, 0.0f, 1.0f);
+        edited |= ImGui::DragFloat3("Position", &position[0], 0.05f);
+        edited |= ImGui::ColorEdit3("Color", &color[0]);
+        edited |= ImGui::DragFloat("Radius", &sphere.radius, 0.05f, 0.1f);
+        edited |= ImGui::DragFloat("Reflection", &sphere.reflection, 0.01f, 0.0f, 1.0f);
 
         ImGui::EndChild();
     }
@@ -139,12 +149,12 @@ void GUI::myObjects()
         glm::vec3& halfSize = cubes.size;
         glm::vec3& color = cubes.color;
 
-        ImGui::DragFloat3("Position", &position[0], 0.05f);
-        ImGui::DragFloat3("Rotation", &rotation[0], 0.05f);
-        ImGui::DragFloat3("Size", &halfSize[0], 0.05f);
-        ImGui::ColorEdit3("Color", &color[0]);
-        ImGui::DragFloat("Rounding", &cubes.rounding, 0.01f, 0.0f);
-        ImGui::DragFloat("Reflection", &cubes.reflection, 0.01f, 0.0f, 1.0f);
+        edited |= ImGui::DragFloat3("Position", &position[0], 0.05f);
+        edited |= ImGui::DragFloat3("Rotation", &rotation[0], 0.05f);
+        edited |= ImGui::DragFloat3("Size", &halfSize[0], 0.05f);
+        edited |= ImGui::ColorEdit3("Color", &color[0]);
+        edited |= ImGui::DragFloat("Rounding", &cubes.rounding, 0.01f, 0.0f);
+        edited |= ImGui::DragFloat("Reflection", &cubes.reflection, 0.01f, 0.0f, 1.0f);
 
         ImGui::EndChild();
     }
@@ -163,17 +173,180 @@ void GUI::myObjects()
         glm::vec3& pos2 = capsule.pos2;
         glm::vec3& color = capsule.color;
 
-        ImGui::DragFloat3("Position", &position[0], 0.05f);
-        ImGui::DragFloat3("Rotation", &rotation[0], 0.05f);
-        ImGui::DragFloat3("Pos1", &pos1[0], 0.05f);
-        ImGui::DragFloat3("Pos2", &pos2[0], 0.05f);
-        ImGui::ColorEdit3("Color", &color[0]);
-        ImGui::DragFloat("Radius", &capsule.radius, 0.01f, 0.0f);
-        ImGui::DragFloat("Reflection", &capsule.reflection, 0.01f, 0.0f, 1.0f);
+        edited |= ImGui::DragFloat3("Position", &position[0], 0.05f);
+        edited |= ImGui::DragFloat3("Rotation", &rotation[0], 0.05f);
+        edited |= ImGui::DragFloat3("Pos1", &pos1[0], 0.05f);
+        edited |= ImGui::DragFloat3("Pos2", &pos2[0], 0.05f);
+        edited |= ImGui::ColorEdit3("Color", &color[0]);
+        edited |= ImGui::DragFloat("Radius", &capsule.radius, 0.01f, 0.0f);
+        edited |= ImGui::DragFloat("Reflection", &capsule.reflection, 0.01f, 0.0f, 1.0f);
 
         ImGui::EndChild();
     }
     ImGui::EndChild();
 
+    ImGui::SeparatorText("Primitives");
+    const std::vector<PrimitiveType>& types = Primitives::types();
+    for (int i = 0; i < objects.primitives.size(); ++i) {
+        if (i > 0) ImGui::Separator();
+        ImGui::PushID(i);
+
+        Primitive& primitive = objects.primitives[i];
+        const PrimitiveType& type = types[primitive.type];
+
+        ImGui::Text("%s", type.name.c_str());
+        edited |= ImGui::DragFloat3("Position", &primitive.center[0], 0.05f);
+        edited |= ImGui::DragFloat3("Rotation", &primitive.rotation[0], 0.05f);
+        for (int p = 0; p < type.params.size(); ++p)
+            edited |= ImGui::DragFloat(type.params[p].c_str(), &Primitives::param(primitive, p), 0.01f);
+        edited |= ImGui::ColorEdit3("Color", &primitive.color[0]);
+        edited |= ImGui::DragFloat("Reflection", &primitive.reflection, 0.01f, 0.0f, 1.0f);
+
+        ImGui::PopID();
+    }
+
+    ImGui::Combo("##Type", &newPrimitiveType, [](void* data, int index) {
+        return (*static_cast<const std::vector<PrimitiveType>*>(data))[index].name.c_str();
+    }, (void*)&types, static_cast<int>(types.size()));
+    ImGui::SameLine();
+    if (ImGui::Button("Add")) {
+        objects.addPrimitive(Primitives::create(newPrimitiveType));
+        edited = true;
+    }
+
+    // Only the leaves and materials are editable, the tree itself is compiled into the shaders
+    ImGui::SeparatorText("CSG Shapes");
+    for (int i = 0; i < objects.csgShapes.size(); ++i) {
+        if (i > 0) ImGui::Separator();
+        ImGui::PushID(1000 + i);
+
+        CsgShape& shape = objects.csgShapes[i];
+        const Csg::Bytecode& bytecode = objects.csgBytecode;
+        bool interpreted = i < bytecode.shapes.size() && bytecode.shapes[i].start >= 0;
+        ImGui::Text(interpreted ? "Bytecode" : "Compiled");
+        edited |= ImGui::ColorEdit3("Color", &shape.color[0]);
+        edited |= ImGui::DragFloat("Reflection", &shape.reflection, 0.01f, 0.0f, 1.0f);
+        // Interpreted trees can change shape, the new leaf is smoothly merged into the root
+        if (interpreted && ImGui::Button("Add Leaf")) {
+            Primitive leaf = Primitives::create(newPrimitiveType);
+            leaf.center = bytecode.bounds[bytecode.shapes[i].boundsSlot - bytecode.boundsOffset].max;
+            shape.root = shape.combine(Csg::Op::Union, shape.root, shape.leaf(leaf), 0.3f);
+            edited = true;
+        }
+
+        for (int n = 0; n < shape.nodes.size(); ++n) {
+            if (shape.nodes[n].op != Csg::Op::Leaf) continue;
+
+            Primitive& leaf = shape.nodes[n].primitive;
+            const PrimitiveType& type = types[leaf.type];
+            ImGui::PushID(n);
+            if (ImGui::TreeNode("Leaf", "%s %d", type.name.c_str(), n)) {
+                edited |= ImGui::DragFloat3("Position", &leaf.center[0], 0.05f);
+                edited |= ImGui::DragFloat3("Rotation", &leaf.rotation[0], 0.05f);
+                for (int p = 0; p < type.params.size(); ++p)
+                    edited |= ImGui::DragFloat(type.params[p].c_str(), &Primitives::param(leaf, p), 0.01f);
+                ImGui::TreePop();
+            }
+            ImGui::PopID();
+        }
+
+        ImGui::PopID();
+    }
+
+    ImGui::End();
+    if (edited) ++sceneEdit;
+}
+
+void GUI::renderWindow()
+{
+    ImGui::Begin("Rendering");
+
+    ImGui::SeparatorText("Renderer");
+    int mode = static_cast<int>(settings.mode);
+    if (ImGui::Combo("Mode", &mode, RenderModeNames, static_cast<int>(RenderMode::Count)) && !benchmark.running)
+        settings.mode = static_cast<RenderMode>(mode);
+    if (settings.mode == RenderMode::Compute)
+        ImGui::DragInt("Work Groups", &settings.computeGroups, 1.0f, 1, 4096);
+    if (settings.mode == RenderMode::ReducedShading) {
+        int quarter = settings.shadingScale == 4;
+        if (ImGui::Combo("Shading Resolution", &quarter, "Half\0Quarter\0"))
+            settings.shadingScale = quarter ? 4 : 2;
+    }
+    if (settings.mode == RenderMode::TAA) {
+        ImGui::DragFloat("Blend", &settings.taaBlend, 0.005f, 0.01f, 1.0f);
+        ImGui::DragFloat("Variance Gamma", &settings.varianceGamma, 0.01f, 0.25f, 4.0f);
+    }
+    ImGui::Checkbox("Analytic Spheres, Cubes And Capsules", &settings.analyticHits);
+    ImGui::Text("GPU: %.3f ms", benchmark.gpuMs);
+    if (benchmark.running) ImGui::Text("Benchmark running...");
+    else if (ImGui::Button("Run Benchmark")) benchmark.start(settings);
+
+    ImGui::SeparatorText("Frame Pacing");
+    int vsync = static_cast<int>(pacer.vsync);
+    if (ImGui::Combo("VSync", &vsync, VSyncNames, static_cast<int>(VSync::Count)))
+        pacer.vsync = static_cast<VSync>(vsync);
+    ImGui::DragFloat("FPS Cap (0: none)", &pacer.fpsCap, 1.0f, 0.0f, 1000.0f);
+    ImGui::SliderInt("Frames In Flight", &pacer.maxFramesInFlight, 1, 3);
+    ImGui::Text("Frame: %.2f ms, input to GPU done: %.2f ms", pacer.frameMs, pacer.latencyMs);
+
+    ImGui::SeparatorText("Reflections");
+    ImGui::SliderInt("Max Bounces", &settings.maxBounces, 0, 8);
+    ImGui::DragInt("Step Budget", &settings.stepBudget, 4.0f, 16, 4096);
+    ImGui::DragFloat("Min Reflectance", &settings.minReflectance, 0.005f, 0.0f, 1.0f);
+    ImGui::Checkbox("No Shadows On Bounces", &settings.cheapBounceLighting);
+
+    ImGui::SeparatorText("March Limits");
+    ImGui::DragFloat("Max Distance", &settings.maxDist, 0.5f, 1.0f, 500.0f);
+    ImGui::DragFloat("Max Shadow Distance", &settings.maxShadowDist, 0.5f, 0.0f, 500.0f);
+    ImGui::DragFloat("Surface Epsilon", &settings.surfaceEpsilon, 0.0005f, 0.0001f, 0.1f, "%.4f");
+
+    ImGui::SeparatorText("Level Of Detail");
+    ImGui::DragFloat("Hit Tolerance (px)", &settings.lodEpsilon, 0.05f, 0.0f, 8.0f);
+    ImGui::DragFloat("Proxy Below (px)", &settings.lodPixels, 0.05f, 0.0f, 16.0f);
+    ImGui::DragFloat("Simple Shading Past", &settings.lodShadeDistance, 0.5f, 0.0f, 50.0f);
+
+    ImGui::SeparatorText("Brick Map");
+    ImGui::Checkbox("Use Brick Map", &settings.useBrickMap);
+    ImGui::DragFloat("Cell Size", &brickMap.cellSize, 0.05f, 0.1f, 16.0f);
+    if (ImGui::Button("Bake")) brickMap.bake(objects);
+    if (!brickMap.baked && settings.useBrickMap) ImGui::TextDisabled("Not baked, or the objects changed since");
+    if (brickMap.baked)
+        ImGui::Text("%dx%dx%d cells, %d bricks", brickMap.cells.x, brickMap.cells.y, brickMap.cells.z, brickMap.brickCount);
+
+    ImGui::SeparatorText("Scene Lookup");
+    int lookup = static_cast<int>(settings.lookup);
+    if (ImGui::Combo("Lookup", &lookup, SceneLookupNames, static_cast<int>(SceneLookup::Count)) && !benchmark.running)
+        settings.lookup = static_cast<SceneLookup>(lookup);
+    if (settings.lookup == SceneLookup::Grid) {
+        ImGui::DragInt("Cells Per Object", &grid.settings.cellsPerObject, 0.1f, 1, 64);
+        ImGui::DragInt("Max Cells Per Axis", &grid.settings.maxCellsPerAxis, 1.0f, 4, 256);
+        ImGui::Text("%dx%dx%d cells of %.2f, %d references", grid.cells.x, grid.cells.y, grid.cells.z, grid.cellSize, grid.references);
+        ImGui::Text("%d objects tested everywhere", grid.unboundedCount);
+    }
+
+    ImGui::SeparatorText("Tile Culling");
+    ImGui::Checkbox("Cull Per Tile", &settings.tileCulling);
+    if (settings.tileCulling) {
+        ImGui::SliderInt("Tile Size", &culling.tileSize, 8, 64);
+        ImGui::Text("%dx%d tiles, %d references", culling.tilesX, culling.tilesY, culling.references);
+        ImGui::Text("%d objects culled, %d in every tile", culling.culled, culling.unboundedCount);
+    }
+
+    ImGui::End();
+}
+
+void GUI::sceneWindow()
+{
+    ImGui::Begin("Scene");
+
+    ImGui::InputText("Path", scenePath, sizeof(scenePath));
+    ImGui::TextDisabled(".sceneb saves and loads the binary format");
+    if (ImGui::Button("Load")) {
+        Scene::load(scenePath, objects, lightSys, camera);
+        ++sceneEdit;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Save")) Scene::save(scenePath, objects, lightSys, camera);
+
     ImGui::End();
 }
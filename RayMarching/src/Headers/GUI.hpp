@@ -6,25 +6,45 @@
 #include "LightingSystem.hpp"
 #include "Objects.hpp"
 #include "Camera.hpp"
+#include "RenderSettings.hpp"
+#include "Benchmark.hpp"
+#include "BrickMap.hpp"
+#include "UniformGrid.hpp"
+#include "TileCulling.hpp"
+#include "FramePacer.hpp"
+#include "Scene.hpp"
 
 class GUI {
 private:
 	Objects& objects;
 	LightingSystem& lightSys;
 	Camera& camera;
+	RenderSettings& settings;
+	Benchmark& benchmark;
+	BrickMap& brickMap;
+	UniformGrid& grid;
+	TileCulling& culling;
+	FramePacer& pacer;
 
 public:
-	GUI(GLFWwindow* window, Camera& camera, Objects& objects, LightingSystem& lightSys);
+	// Bumped whenever the GUI or a scene load changed the objects or point lights, see Simulation::publishScene()
+	int sceneEdit = 0;
+
+	GUI(GLFWwindow* window, Camera& camera, Objects& objects, LightingSystem& lightSys, RenderSettings& settings, Benchmark& benchmark, BrickMap& brickMap, UniformGrid& grid, TileCulling& culling, FramePacer& pacer, const std::string& scenePath);
 
 	void update();
 	void render();
 
 private:
 	bool lightingWindow = true;
+	char scenePath[256] = "scene.scene";
+	int newPrimitiveType = 0;
 
 	void lightAndCamWindow();
 	void lighting();
 	void cameraWindow();
 	void myObjects();
+	void renderWindow();
+	void sceneWindow();
 };
 
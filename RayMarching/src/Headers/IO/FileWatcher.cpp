@@ -0,0 +1,79 @@
+#include "FileWatcher.hpp"
+#include <algorithm>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <thread>
+#endif
+
+#ifdef __linux__
+IO::FileWatcher::FileWatcher(const std::string& directory) : directory(directory)
+{
+	fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	// Editors often save by writing a temporary file and renaming it over the original
+	if (fd >= 0) inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+}
+
+IO::FileWatcher::~FileWatcher()
+{
+	if (fd >= 0) close(fd);
+}
+
+std::vector<std::string> IO::FileWatcher::wait(int timeoutMs)
+{
+	std::vector<std::string> changed;
+	pollfd request = { fd, POLLIN, 0 };
+	if (fd < 0 || poll(&request, 1, timeoutMs) <= 0) return changed;
+
+	alignas(inotify_event) char buffer[4096];
+	ssize_t length;
+	while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+		for (char* ptr = buffer; ptr < buffer + length; ) {
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+			if (event->len > 0) {
+				std::string path = (directory / event->name).lexically_normal().string();
+				if (std::find(changed.begin(), changed.end(), path) == changed.end()) changed.push_back(path);
+			}
+			ptr += sizeof(inotify_event) + event->len;
+		}
+	}
+	return changed;
+}
+#else
+IO::FileWatcher::FileWatcher(const std::string& directory) : directory(directory)
+{
+	scan();
+}
+
+IO::FileWatcher::~FileWatcher()
+{
+}
+
+std::vector<std::string> IO::FileWatcher::wait(int timeoutMs)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+	return scan();
+}
+
+std::vector<std::string> IO::FileWatcher::scan()
+{
+	std::vector<std::string> changed;
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+		if (!entry.is_regular_file(error)) continue;
+
+		std::string path = entry.path().lexically_normal().string();
+		auto time = entry.last_write_time(error);
+		auto it = writeTimes.find(path);
+		if (it == writeTimes.end()) writeTimes.emplace(path, time);
+		else if (it->second != time) {
+			it->second = time;
+			changed.push_back(path);
+		}
+	}
+	return changed;
+}
+#endif
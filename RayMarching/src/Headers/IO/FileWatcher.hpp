@@ -0,0 +1,30 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace IO {
+	// Reports files written in a directory (not recursive).
+	// Uses inotify on Linux and compares write times everywhere else
+	class FileWatcher {
+	private:
+		std::filesystem::path directory;
+#ifdef __linux__
+		int fd = -1;
+#else
+		std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes;
+
+		std::vector<std::string> scan();
+#endif
+
+	public:
+		explicit FileWatcher(const std::string& directory);
+		~FileWatcher();
+		FileWatcher(const FileWatcher&) = delete;
+		FileWatcher& operator=(const FileWatcher&) = delete;
+
+		// Blocks for at most timeoutMs and returns the normalized paths of the files that changed
+		std::vector<std::string> wait(int timeoutMs);
+	};
+}
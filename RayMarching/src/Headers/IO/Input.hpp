@@ -39,8 +39,9 @@ void inline mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
 		firstMouse = false;
 	}
 
-	xoffset = xpos - lastX;
-	yoffset = lastY - ypos;
+	// Summed until processInput(), there can be several moves per frame
+	xoffset += xpos - lastX;
+	yoffset += lastY - ypos;
 
 	lastX = xpos;
 	lastY = ypos;
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace IO {
+	// Read-only memory mapping of a whole file
+	class MappedFile {
+	private:
+		const char* view = nullptr;
+		size_t length = 0;
+#ifdef _WIN32
+		void* file = nullptr;
+		void* mapping = nullptr;
+#endif
+
+	public:
+		explicit MappedFile(const std::string& path);
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool isOpen() const { return view != nullptr; }
+		const char* data() const { return view; }
+		size_t size() const { return length; }
+	};
+}
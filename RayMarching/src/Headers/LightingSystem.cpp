@@ -1,29 +1,49 @@
 #include "LightingSystem.hpp"
 
-void LightingSystem::update(Shader& shader)
-{
-	
-	shader.setVec3("dirLight.direction", dirLight.direction);
-	shader.setVec3("dirLight.color", dirLight.color);
-	shader.setVec3("dirLight.ambient", dirLight.ambient);
-	shader.setVec3("dirLight.diffuse", dirLight.diffuse);
-	shader.setVec3("dirLight.specular", dirLight.specular);
+// std430 layout of the PointLight struct in RayMarching.glsl
+namespace {
+	struct GPUPointLight {
+		glm::vec3 position;
+		float constant;
+		glm::vec3 ambient;
+		float linear;
+		glm::vec3 diffuse;
+		float quadratic;
+		glm::vec3 specular;
+		float padding0;
+		glm::vec3 color;
+		float padding1;
+	};
 
-	for (int i = 0; i < pointLights.size(); ++i) {
-		std::string name = "pointLights[" + std::to_string(i) + "].";
-		PointLight& pointLight = pointLights[i];
+	static_assert(sizeof(GPUPointLight) == 80);
+}
 
-		shader.setVec3(name + "position", pointLight.position);
-		shader.setVec3(name + "ambient", pointLight.ambient);
-		shader.setVec3(name + "diffuse", pointLight.diffuse);
-		shader.setVec3(name + "specular", pointLight.specular);
-		shader.setVec3(name + "color", pointLight.color);
-		shader.setFloat(name + "constant", pointLight.constant);
-		shader.setFloat(name + "linear", pointLight.linear);
-		shader.setFloat(name + "quadratic", pointLight.quadratic);
+void LightingSystem::pack(PackedLights& packed) const
+{
+	packed.count = static_cast<int>(pointLights.size());
+	packed.pointLights.resize(pointLights.size() * sizeof(GPUPointLight));
+	GPUPointLight* gpuLights = reinterpret_cast<GPUPointLight*>(packed.pointLights.data());
+	for (int i = 0; i < pointLights.size(); ++i) {
+		const PointLight& light = pointLights[i];
+		gpuLights[i] = { light.position, light.constant, light.ambient, light.linear,
+			light.diffuse, light.quadratic, light.specular, 0.0f, light.color, 0.0f };
 	}
 }
 
+void LightingSystem::upload(const PackedLights& packed)
+{
+	pointLightBuffer.upload(packed.pointLights);
+	uploadedCount = packed.count;
+}
+
+void LightingSystem::update(Shader& shader)
+{
+	// The directional light is part of the per frame uniform buffer, see FrameUniforms
+	shader.setBool("showLights", showLightProxies);
+
+	shader.setInt("lightCount", uploadedCount);
+}
+
 void LightingSystem::addPointLight(PointLight pointlight)
 {
 	pointLights.emplace_back(pointlight);;
@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include "Shaders/Shader.hpp"
+#include "StorageBuffer.hpp"
 
 struct DirectionalLight {
 	glm::vec3 direction = { 0.2f, -1.0f, -0.15 };
@@ -21,11 +22,26 @@ struct PointLight {
 	float quadratic = 0.032f;
 };
 
+// Point lights in the layout of their storage block, see Objects::pack() for why
+struct PackedLights {
+	std::vector<unsigned char> pointLights;
+	int count = 0;
+};
+
 class LightingSystem {
 public:
 	DirectionalLight dirLight;
 	std::vector<PointLight> pointLights;
+	bool showLightProxies = true;
 
+private:
+	// Binding matches the storage block in RayMarching.glsl
+	StorageBuffer pointLightBuffer{ 7 };
+	int uploadedCount = 0;
+
+public:
+	void pack(PackedLights& packed) const;
+	void upload(const PackedLights& packed);
 	void update(Shader& shader);
 	void addPointLight(PointLight pointlight);
 };
@@ -1,6 +1,91 @@
 #include "Objects.hpp"
+#include <cmath>
+#include <iostream>
 
-glm::mat4 getMatrix(Cube& cube)
+// std430 layouts of the structs in RayMarching.glsl
+namespace {
+	struct GPUSphere {
+		glm::vec3 center;
+		float radius;
+		glm::vec3 color;
+		float reflection;
+	};
+
+	struct GPUCube {
+		glm::mat4 inverseTransormation;
+		glm::vec3 halfSize;
+		float reflection;
+		glm::vec3 color;
+		float rounding;
+	};
+
+	struct GPUCapsule {
+		glm::mat4 inverseTransormation;
+		glm::vec3 pos1;
+		float reflection;
+		glm::vec3 pos2;
+		float radius;
+		glm::vec3 color;
+		float padding;
+	};
+
+	struct GPUPrimitive {
+		glm::mat4 inverseTransormation;
+		glm::vec4 a;
+		glm::vec4 b;
+		glm::vec3 color;
+		float reflection;
+		glm::vec3 lodCenter;
+		float lodRadius;
+		int type;
+		int padding[3];
+	};
+
+	struct GPUBounds {
+		glm::vec4 lower;
+		glm::vec4 upper;
+	};
+
+	struct GPUCsgShape {
+		glm::vec3 color;
+		float reflection;
+		int codeStart;
+		int codeEnd;
+		int boundsSlot;
+		int padding;
+	};
+
+	struct GPUCsgInstruction {
+		glm::vec3 pivot;
+		float blend;
+		glm::vec3 spacing;
+		int op;
+		glm::ivec3 limit;
+		int arg;
+	};
+
+	GPUPrimitive packPrimitive(const Primitive& primitive)
+	{
+		// World space bounding sphere, the stand in once the primitive is too small on screen
+		Bounds world = Primitives::worldBounds(primitive);
+		glm::vec3 center = (world.min + world.max) * 0.5f;
+		float radius = glm::length(world.max - world.min) * 0.5f;
+		return { glm::inverse(getMatrix(primitive)), primitive.a, primitive.b, primitive.color, primitive.reflection, center, radius, primitive.type, {} };
+	}
+
+	static_assert(sizeof(GPUSphere) == 32 && sizeof(GPUCube) == 96 && sizeof(GPUCapsule) == 112 && sizeof(GPUPrimitive) == 144);
+	static_assert(sizeof(GPUCsgShape) == 32 && sizeof(GPUCsgInstruction) == 48);
+
+	// How many objects of a type get into the lookup lists, an index past MaxPackedObjects would spill into the type bits
+	int packedCount(size_t count, const char* type)
+	{
+		if (count <= MaxPackedObjects) return static_cast<int>(count);
+		std::cerr << "ERROR::OBJECTS::TOO_MANY_" << type << ": " << count << ", only the first " << MaxPackedObjects << " are in the lookup" << std::endl;
+		return MaxPackedObjects;
+	}
+}
+
+glm::mat4 getMatrix(const Cube& cube)
 {
 	glm::mat4 model = glm::mat4(1.0f);
 	model = glm::translate(model, cube.center);
@@ -12,7 +97,7 @@ glm::mat4 getMatrix(Cube& cube)
 	return model;
 }
 
-glm::mat4 getMatrix(Capsule& capsule)
+glm::mat4 getMatrix(const Capsule& capsule)
 {
 	glm::mat4 model = glm::mat4(1.0f);
 	model = glm::translate(model, capsule.center);
@@ -24,41 +109,127 @@ glm::mat4 getMatrix(Capsule& capsule)
 	return model;
 }
 
-void Objects::update(Shader& shader)
+// Room for count elements of T in a packed array
+template<typename T>
+static T* packArray(std::vector<unsigned char>& bytes, size_t count)
 {
-	for (int i = 0; i < spheres.size(); ++i) {
-		std::string name = "spheres[" + std::to_string(i) + "].";
-		Sphere& sphere = spheres[i];
-
-		shader.setFloat(name + "radius", sphere.radius);
-		shader.setFloat(name + "reflection", sphere.reflection);
-		shader.setVec3(name + "center", sphere.center);
-		shader.setVec3(name + "color", sphere.color);
+	bytes.resize(count * sizeof(T));
+	return reinterpret_cast<T*>(bytes.data());
+}
+
+void Objects::pack(PackedObjects& packed) const
+{
+	packed.counts = { static_cast<int>(spheres.size()), static_cast<int>(cubes.size()), static_cast<int>(capsules.size()),
+		static_cast<int>(primitives.size()), static_cast<int>(csgShapes.size()) };
+
+	GPUSphere* gpuSpheres = packArray<GPUSphere>(packed.spheres, spheres.size());
+	for (int i = 0; i < spheres.size(); ++i)
+		gpuSpheres[i] = { spheres[i].center, spheres[i].radius, spheres[i].color, spheres[i].reflection };
+
+	GPUCube* gpuCubes = packArray<GPUCube>(packed.cubes, cubes.size());
+	for (int i = 0; i < cubes.size(); ++i)
+		gpuCubes[i] = { glm::inverse(getMatrix(cubes[i])), cubes[i].size, cubes[i].reflection, cubes[i].color, cubes[i].rounding };
+
+	GPUCapsule* gpuCapsules = packArray<GPUCapsule>(packed.capsules, capsules.size());
+	for (int i = 0; i < capsules.size(); ++i) {
+		const Capsule& capsule = capsules[i];
+		gpuCapsules[i] = { glm::inverse(getMatrix(capsule)), capsule.pos1, capsule.reflection, capsule.pos2, capsule.radius, capsule.color, 0.0f };
 	}
-	
-	for (int i = 0; i < cubes.size(); ++i) {
-		std::string name = "cubes[" + std::to_string(i) + "].";
-		Cube& cube = cubes[i];
-
-		shader.setVec3(name + "halfSize", cube.size);
-		shader.setFloat(name + "reflection", cube.reflection);
-		shader.setFloat(name + "rounding", cube.rounding);
-		shader.setVec3(name + "color", cube.color);
-		shader.setMat4(name + "inverseTransormation", glm::inverse(getMatrix(cube)));
+
+	GPUPrimitive* gpuPrimitives = packArray<GPUPrimitive>(packed.primitives, primitives.size());
+	for (int i = 0; i < primitives.size(); ++i)
+		gpuPrimitives[i] = packPrimitive(primitives[i]);
+
+	// Interpreted leaves and bounds go after the compiled ones
+	Csg::Bytecode& csgBytecode = packed.csgBytecode;
+	csgBytecode = Csg::assemble(csgShapes, csgProgram);
+
+	std::vector<const Primitive*> leaves = Csg::leaves(csgProgram, csgShapes);
+	leaves.insert(leaves.end(), csgBytecode.leaves.begin(), csgBytecode.leaves.end());
+	GPUPrimitive* gpuLeaves = packArray<GPUPrimitive>(packed.csgLeaves, leaves.size());
+	for (int i = 0; i < leaves.size(); ++i)
+		gpuLeaves[i] = packPrimitive(*leaves[i]);
+	csgBytecode.leaves.clear();
+
+	std::vector<Bounds> bounds = Csg::computeBounds(csgProgram, csgShapes);
+	bounds.insert(bounds.end(), csgBytecode.bounds.begin(), csgBytecode.bounds.end());
+	GPUBounds* gpuBounds = packArray<GPUBounds>(packed.csgBounds, bounds.size());
+	for (int i = 0; i < bounds.size(); ++i)
+		gpuBounds[i] = { glm::vec4(bounds[i].min, 0.0f), glm::vec4(bounds[i].max, 0.0f) };
+
+	packed.bounds = objectBounds();
+	Bounds& sceneBounds = packed.sceneBounds;
+	sceneBounds = { glm::vec3(INFINITY), glm::vec3(-INFINITY) };
+	for (const ObjectBounds& object : packed.bounds) {
+		sceneBounds.min = glm::min(sceneBounds.min, object.bounds.min);
+		sceneBounds.max = glm::max(sceneBounds.max, object.bounds.max);
 	}
-	for (int i = 0; i < capsules.size(); ++i) {
-		std::string name = "capsules[" + std::to_string(i) + "].";
-		Capsule& capsule = capsules[i];
-
-		shader.setVec3(name + "pos1", capsule.pos1);
-		shader.setVec3(name + "pos2", capsule.pos2);
-		shader.setFloat(name + "reflection", capsule.reflection);
-		shader.setFloat(name + "radius", capsule.radius);
-		shader.setVec3(name + "color", capsule.color);
-		shader.setMat4(name + "inverseTransormation", glm::inverse(getMatrix(capsule)));
+
+	packed.sceneUnbounded = false;
+	GPUCsgShape* gpuShapes = packArray<GPUCsgShape>(packed.csgShapes, csgShapes.size());
+	for (int i = 0; i < csgShapes.size(); ++i) {
+		const Csg::Bytecode::Range& range = csgBytecode.shapes[i];
+		int boundsSlot = range.boundsSlot;
+		if (i < csgProgram.shapes.size() && csgProgram.shapes[i].root >= 0)
+			boundsSlot = csgProgram.shapes[i].nodes[csgProgram.shapes[i].root].boundsSlot;
+		gpuShapes[i] = { csgShapes[i].color, csgShapes[i].reflection, range.start, range.end, boundsSlot, 0 };
+
+		if (boundsSlot < 0) continue;
+		const Bounds& shape = bounds[boundsSlot];
+		if (std::isinf(shape.min.x) || std::isinf(shape.min.y) || std::isinf(shape.min.z)
+			|| std::isinf(shape.max.x) || std::isinf(shape.max.y) || std::isinf(shape.max.z)) {
+			packed.sceneUnbounded = true;
+			continue;
+		}
+		sceneBounds.min = glm::min(sceneBounds.min, shape.min);
+		sceneBounds.max = glm::max(sceneBounds.max, shape.max);
+	}
+
+	GPUCsgInstruction* gpuCode = packArray<GPUCsgInstruction>(packed.csgCode, csgBytecode.code.size());
+	for (int i = 0; i < csgBytecode.code.size(); ++i) {
+		const Csg::Instruction& instruction = csgBytecode.code[i];
+		gpuCode[i] = { instruction.pivot, instruction.blend, instruction.spacing, static_cast<int>(instruction.op), instruction.limit, instruction.arg };
 	}
 }
 
+void Objects::upload(const PackedObjects& packed)
+{
+	// Copied straight into the mapped buffers, see StorageBuffer::map()
+	sphereBuffer.upload(packed.spheres);
+	cubeBuffer.upload(packed.cubes);
+	capsuleBuffer.upload(packed.capsules);
+	primitiveBuffer.upload(packed.primitives);
+	csgLeafBuffer.upload(packed.csgLeaves);
+	csgBoundsBuffer.upload(packed.csgBounds);
+	csgShapeBuffer.upload(packed.csgShapes);
+	csgCodeBuffer.upload(packed.csgCode);
+
+	uploaded = packed.counts;
+	sceneBounds = packed.sceneBounds;
+	sceneUnbounded = packed.sceneUnbounded;
+	csgBytecode = packed.csgBytecode;
+}
+
+void Objects::upload()
+{
+	PackedObjects packed;
+	pack(packed);
+	upload(packed);
+}
+
+void Objects::update(Shader& shader)
+{
+	// The counts of what is in the buffers, the vectors may already be ahead of them
+	shader.setInt("sphereCount", uploaded.spheres);
+	shader.setInt("cubeCount", uploaded.cubes);
+	shader.setInt("capsuleCount", uploaded.capsules);
+	shader.setInt("primitiveCount", uploaded.primitives);
+	shader.setInt("csgCount", uploaded.csgShapes);
+	shader.setVec3("sceneMin", sceneBounds.min);
+	shader.setVec3("sceneMax", sceneBounds.max);
+	shader.setBool("sceneUnbounded", sceneUnbounded);
+}
+
 void Objects::addSphere(Sphere sphere)
 {
 	spheres.emplace_back(sphere);
@@ -73,3 +244,62 @@ void Objects::addCapsule(Capsule capsule)
 {
 	capsules.emplace_back(capsule);
 }
+
+void Objects::addPrimitive(Primitive primitive)
+{
+	primitives.emplace_back(primitive);
+}
+
+void Objects::addCsgShape(CsgShape shape)
+{
+	csgShapes.emplace_back(shape);
+}
+
+std::vector<ObjectBounds> Objects::objectBounds() const
+{
+	std::vector<ObjectBounds> all;
+	all.reserve(spheres.size() + cubes.size() + capsules.size() + primitives.size());
+
+	for (int i = 0, count = packedCount(spheres.size(), "SPHERES"); i < count; ++i) {
+		const Sphere& sphere = spheres[i];
+		all.push_back({ packObject(ObjectType::Sphere, i), { sphere.center - glm::vec3(sphere.radius), sphere.center + glm::vec3(sphere.radius) } });
+	}
+	for (int i = 0, count = packedCount(cubes.size(), "CUBES"); i < count; ++i) {
+		const Cube& cube = cubes[i];
+		glm::mat4 model = getMatrix(cube);
+		Bounds bounds{ glm::vec3(INFINITY), glm::vec3(-INFINITY) };
+		for (int corner = 0; corner < 8; ++corner) {
+			glm::vec3 point(corner & 1 ? cube.size.x : -cube.size.x, corner & 2 ? cube.size.y : -cube.size.y, corner & 4 ? cube.size.z : -cube.size.z);
+			glm::vec3 transformed = glm::vec3(model * glm::vec4(point, 1.0f));
+			bounds.min = glm::min(bounds.min, transformed - glm::vec3(cube.rounding));
+			bounds.max = glm::max(bounds.max, transformed + glm::vec3(cube.rounding));
+		}
+		all.push_back({ packObject(ObjectType::Cube, i), bounds });
+	}
+	for (int i = 0, count = packedCount(capsules.size(), "CAPSULES"); i < count; ++i) {
+		const Capsule& capsule = capsules[i];
+		glm::mat4 model = getMatrix(capsule);
+		glm::vec3 a = glm::vec3(model * glm::vec4(capsule.pos1, 1.0f));
+		glm::vec3 b = glm::vec3(model * glm::vec4(capsule.pos2, 1.0f));
+		all.push_back({ packObject(ObjectType::Capsule, i), { glm::min(a, b) - glm::vec3(capsule.radius), glm::max(a, b) + glm::vec3(capsule.radius) } });
+	}
+	for (int i = 0, count = packedCount(primitives.size(), "PRIMITIVES"); i < count; ++i)
+		all.push_back({ packObject(ObjectType::Primitive, i), Primitives::worldBounds(primitives[i]) });
+	return all;
+}
+
+Bounds Objects::staticBounds() const
+{
+	Bounds bounds{ glm::vec3(INFINITY), glm::vec3(-INFINITY) };
+	for (const ObjectBounds& object : objectBounds()) {
+		bounds.min = glm::min(bounds.min, object.bounds.min);
+		bounds.max = glm::max(bounds.max, object.bounds.max);
+	}
+	return bounds;
+}
+
+const std::string& Objects::compileCsg()
+{
+	csgProgram = Csg::compile(csgShapes);
+	return csgProgram.glsl;
+}
@@ -2,12 +2,17 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include "Shaders/Shader.hpp"
+#include "StorageBuffer.hpp"
+#include "Primitives.hpp"
+#include "Csg.hpp"
 
 struct Sphere {
 	float radius = 1.0f;
 	glm::vec3 center = glm::vec3(0.0f);
 	glm::vec3 color = glm::vec3(1.0f);
 	float reflection = 0.0f;
+
+	bool operator==(const Sphere&) const = default;
 };
 
 struct Cube {
@@ -18,6 +23,8 @@ struct Cube {
 	glm::vec3 color = glm::vec3(1.0f);
 	float reflection = 0.0f;
 	float rounding = 0.0f;
+
+	bool operator==(const Cube&) const = default;
 };
 
 struct Capsule {
@@ -29,21 +36,105 @@ struct Capsule {
 	glm::vec3 color = glm::vec3(1.0f);
 	float reflection = 0.0f;
 	float radius = 1.0f;
+
+	bool operator==(const Capsule&) const = default;
+};
+
+glm::mat4 getMatrix(const Cube& cube);
+glm::mat4 getMatrix(const Capsule& capsule);
+
+// Types and packing of the objects in RayMarching.glsl, see the type defines and packObject().
+// The type takes the top 8 bits and the index the low 24, so a type holds at most MaxPackedObjects
+enum class ObjectType { Light, Sphere, Cube, Capsule, Primitive, Csg };
+
+constexpr int ObjectIndexBits = 24;
+constexpr int MaxPackedObjects = 1 << ObjectIndexBits;
+
+inline int packObject(ObjectType type, int index)
+{
+	return (static_cast<int>(type) << ObjectIndexBits) | index;
+}
+
+struct ObjectBounds {
+	int object; // Packed
+	Bounds bounds;
 };
 
-glm::mat4 getMatrix(Cube& cube);
-glm::mat4 getMatrix(Capsule& capsule);
+// The objects in the layouts of their storage blocks, built by Objects::pack() on any thread
+// (the update thread every frame) and handed to Objects::upload() on the render thread
+struct PackedObjects {
+	std::vector<unsigned char> spheres;
+	std::vector<unsigned char> cubes;
+	std::vector<unsigned char> capsules;
+	std::vector<unsigned char> primitives;
+	std::vector<unsigned char> csgLeaves;
+	std::vector<unsigned char> csgBounds;
+	std::vector<unsigned char> csgShapes;
+	std::vector<unsigned char> csgCode;
+
+	struct Counts {
+		int spheres = 0;
+		int cubes = 0;
+		int capsules = 0;
+		int primitives = 0;
+		int csgShapes = 0;
+	} counts;
+
+	// Of the packed objects, the indices match the buffers above
+	std::vector<ObjectBounds> bounds;
+	Bounds sceneBounds{ glm::vec3(0.0f), glm::vec3(0.0f) };
+	bool sceneUnbounded = false;
+	// Without its leaves, they point into the objects that were packed
+	Csg::Bytecode csgBytecode;
+};
 
 class Objects {
 public:
 	std::vector<Sphere> spheres;
 	std::vector<Cube> cubes;
 	std::vector<Capsule> capsules;
+	// Every type from the primitive registry
+	std::vector<Primitive> primitives;
+	// The tree structure is compiled into the shaders, see compileCsg(),
+	// dynamic shapes and shapes added after the compile are interpreted from csgBytecode
+	std::vector<CsgShape> csgShapes;
+	Csg::Program csgProgram;
+	Csg::Bytecode csgBytecode;
+	// Box around every object as of the last upload(), rays are clipped to it before marching.
+	// CSG shapes repeated forever are left out of it, while there are any rays are marched unclipped
+	Bounds sceneBounds;
+	bool sceneUnbounded = false;
+
+private:
+	PackedObjects::Counts uploaded;
+
+	// Bindings match the storage blocks in RayMarching.glsl
+	StorageBuffer sphereBuffer{ 4 };
+	StorageBuffer cubeBuffer{ 5 };
+	StorageBuffer capsuleBuffer{ 6 };
+	StorageBuffer primitiveBuffer{ 8 };
+	StorageBuffer csgLeafBuffer{ 9 };
+	StorageBuffer csgBoundsBuffer{ 10 };
+	StorageBuffer csgShapeBuffer{ 11 };
+	StorageBuffer csgCodeBuffer{ 12 };
 
 public:
+	// Only reads the objects, so a copy of them can be packed on another thread
+	void pack(PackedObjects& packed) const;
+	void upload(const PackedObjects& packed);
+	// Packs and uploads the objects as they are now
+	void upload();
 	void update(Shader& shader);
 
 	void addSphere(Sphere sphere);
 	void addCube(Cube cube);
 	void addCapsule(Capsule capsule);
+	void addPrimitive(Primitive primitive);
+	void addCsgShape(CsgShape shape);
+	// World space boxes of the spheres, cubes, capsules and primitives, the objects staticDist() evaluates
+	std::vector<ObjectBounds> objectBounds() const;
+	// All of them together, the volume the brick map bakes
+	Bounds staticBounds() const;
+	// Compiles csgShapes and returns the Csg.glsl source, shapes added later are interpreted until the next compile
+	const std::string& compileCsg();
 };
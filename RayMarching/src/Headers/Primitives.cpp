@@ -0,0 +1,213 @@
+#include "Primitives.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+static float dot2(glm::vec2 v)
+{
+	return glm::dot(v, v);
+}
+
+// Distance functions from Inigo Quilez, https://iquilezles.org/articles/distfunctions/
+static std::vector<PrimitiveType> builtinTypes()
+{
+	std::vector<PrimitiveType> types;
+
+	types.push_back({ "Torus", { "Major Radius", "Minor Radius" }, { 1.0f, 0.3f, 0.0f, 0.0f }, glm::vec4(0.0f),
+		"vec2 q = vec2(length(p.xz) - a.x, p.y);\n"
+		"return length(q) - a.y;",
+		[](glm::vec3 p, glm::vec4 a, glm::vec4) {
+			glm::vec2 q(glm::length(glm::vec2(p.x, p.z)) - a.x, p.y);
+			return glm::length(q) - a.y;
+		},
+		[](glm::vec4 a, glm::vec4) {
+			glm::vec3 extent(a.x + a.y, a.y, a.x + a.y);
+			return Bounds{ -extent, extent };
+		} });
+
+	types.push_back({ "Cylinder", { "Radius", "Half Height" }, { 0.5f, 1.0f, 0.0f, 0.0f }, glm::vec4(0.0f),
+		"vec2 d = abs(vec2(length(p.xz), p.y)) - a.xy;\n"
+		"return min(max(d.x, d.y), 0.0) + length(max(d, 0.0));",
+		[](glm::vec3 p, glm::vec4 a, glm::vec4) {
+			glm::vec2 d = glm::abs(glm::vec2(glm::length(glm::vec2(p.x, p.z)), p.y)) - glm::vec2(a.x, a.y);
+			return glm::min(glm::max(d.x, d.y), 0.0f) + glm::length(glm::max(d, 0.0f));
+		},
+		[](glm::vec4 a, glm::vec4) {
+			glm::vec3 extent(a.x, a.y, a.x);
+			return Bounds{ -extent, extent };
+		} });
+
+	types.push_back({ "Cone", { "Half Height", "Bottom Radius", "Top Radius" }, { 1.0f, 0.8f, 0.2f, 0.0f }, glm::vec4(0.0f),
+		"vec2 q = vec2(length(p.xz), p.y);\n"
+		"vec2 k1 = vec2(a.z, a.x);\n"
+		"vec2 k2 = vec2(a.z - a.y, 2.0 * a.x);\n"
+		"vec2 ca = vec2(q.x - min(q.x, q.y < 0.0 ? a.y : a.z), abs(q.y) - a.x);\n"
+		"vec2 cb = q - k1 + k2 * clamp(dot(k1 - q, k2) / dot(k2, k2), 0.0, 1.0);\n"
+		"float s = (cb.x < 0.0 && ca.y < 0.0) ? -1.0 : 1.0;\n"
+		"return s * sqrt(min(dot(ca, ca), dot(cb, cb)));",
+		[](glm::vec3 p, glm::vec4 a, glm::vec4) {
+			glm::vec2 q(glm::length(glm::vec2(p.x, p.z)), p.y);
+			glm::vec2 k1(a.z, a.x);
+			glm::vec2 k2(a.z - a.y, 2.0f * a.x);
+			glm::vec2 ca(q.x - glm::min(q.x, q.y < 0.0f ? a.y : a.z), glm::abs(q.y) - a.x);
+			glm::vec2 cb = q - k1 + k2 * glm::clamp(glm::dot(k1 - q, k2) / dot2(k2), 0.0f, 1.0f);
+			float s = (cb.x < 0.0f && ca.y < 0.0f) ? -1.0f : 1.0f;
+			return s * glm::sqrt(glm::min(dot2(ca), dot2(cb)));
+		},
+		[](glm::vec4 a, glm::vec4) {
+			float radius = glm::max(a.y, a.z);
+			glm::vec3 extent(radius, a.x, radius);
+			return Bounds{ -extent, extent };
+		} });
+
+	// Infinite in x and z, the bounds only cover the part that can be seen
+	types.push_back({ "Plane", {}, glm::vec4(0.0f), glm::vec4(0.0f),
+		"return p.y;",
+		[](glm::vec3 p, glm::vec4, glm::vec4) { return p.y; },
+		[](glm::vec4, glm::vec4) {
+			glm::vec3 extent(1000.0f, 0.0f, 1000.0f);
+			return Bounds{ -extent, extent };
+		} });
+
+	// Not an exact distance, but a bound that is close near the surface
+	types.push_back({ "Ellipsoid", { "Radius X", "Radius Y", "Radius Z" }, { 1.0f, 0.5f, 0.75f, 0.0f }, glm::vec4(0.0f),
+		"float k0 = length(p / a.xyz);\n"
+		"float k1 = length(p / (a.xyz * a.xyz));\n"
+		"return k0 * (k0 - 1.0) / k1;",
+		[](glm::vec3 p, glm::vec4 a, glm::vec4) {
+			glm::vec3 r(a.x, a.y, a.z);
+			float k0 = glm::length(p / r);
+			float k1 = glm::length(p / (r * r));
+			return k0 * (k0 - 1.0f) / k1;
+		},
+		[](glm::vec4 a, glm::vec4) {
+			glm::vec3 extent(a.x, a.y, a.z);
+			return Bounds{ -extent, extent };
+		} });
+
+	// Along z, the radius is the distance from the axis to the middle of a side
+	types.push_back({ "HexPrism", { "Radius", "Half Length" }, { 0.5f, 1.0f, 0.0f, 0.0f }, glm::vec4(0.0f),
+		"const vec3 k = vec3(-0.8660254, 0.5, 0.57735);\n"
+		"p = abs(p);\n"
+		"p.xy -= 2.0 * min(dot(k.xy, p.xy), 0.0) * k.xy;\n"
+		"vec2 d = vec2(length(p.xy - vec2(clamp(p.x, -k.z * a.x, k.z * a.x), a.x)) * sign(p.y - a.x), p.z - a.y);\n"
+		"return min(max(d.x, d.y), 0.0) + length(max(d, 0.0));",
+		[](glm::vec3 p, glm::vec4 a, glm::vec4) {
+			const glm::vec3 k(-0.8660254f, 0.5f, 0.57735f);
+			p = glm::abs(p);
+			float fold = 2.0f * glm::min(k.x * p.x + k.y * p.y, 0.0f);
+			p.x -= fold * k.x;
+			p.y -= fold * k.y;
+			glm::vec2 edge(p.x - glm::clamp(p.x, -k.z * a.x, k.z * a.x), p.y - a.x);
+			glm::vec2 d(glm::length(edge) * glm::sign(p.y - a.x), p.z - a.y);
+			return glm::min(glm::max(d.x, d.y), 0.0f) + glm::length(glm::max(d, 0.0f));
+		},
+		[](glm::vec4 a, glm::vec4) {
+			// Corners are at radius / cos(30)
+			float corner = a.x * 1.1547005f;
+			glm::vec3 extent(corner, corner, a.y);
+			return Bounds{ -extent, extent };
+		} });
+
+	return types;
+}
+
+static std::vector<PrimitiveType>& registry()
+{
+	static std::vector<PrimitiveType> types = builtinTypes();
+	return types;
+}
+
+glm::mat4 getMatrix(const Primitive& primitive)
+{
+	glm::mat4 model = glm::mat4(1.0f);
+	model = glm::translate(model, primitive.center);
+
+	model = glm::rotate(model, glm::radians(primitive.rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+	model = glm::rotate(model, glm::radians(primitive.rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+	model = glm::rotate(model, glm::radians(primitive.rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+
+	return model;
+}
+
+const std::vector<PrimitiveType>& Primitives::types()
+{
+	return registry();
+}
+
+int Primitives::registerType(PrimitiveType type)
+{
+	registry().push_back(std::move(type));
+	return static_cast<int>(registry().size()) - 1;
+}
+
+int Primitives::find(const std::string& name)
+{
+	const std::vector<PrimitiveType>& all = registry();
+	for (int i = 0; i < all.size(); ++i)
+		if (all[i].name == name) return i;
+	return -1;
+}
+
+Primitive Primitives::create(int type)
+{
+	Primitive primitive;
+	primitive.type = type;
+	primitive.a = registry()[type].defaultA;
+	primitive.b = registry()[type].defaultB;
+	return primitive;
+}
+
+float& Primitives::param(Primitive& primitive, int index)
+{
+	return index < 4 ? primitive.a[index] : primitive.b[index - 4];
+}
+
+float Primitives::distance(const Primitive& primitive, glm::vec3 pos)
+{
+	glm::vec3 local = glm::vec3(glm::inverse(getMatrix(primitive)) * glm::vec4(pos, 1.0f));
+	return registry()[primitive.type].sdf(local, primitive.a, primitive.b);
+}
+
+Bounds Primitives::worldBounds(const Primitive& primitive)
+{
+	Bounds local = registry()[primitive.type].bounds(primitive.a, primitive.b);
+	glm::mat4 model = getMatrix(primitive);
+
+	Bounds world{ glm::vec3(INFINITY), glm::vec3(-INFINITY) };
+	for (int corner = 0; corner < 8; ++corner) {
+		glm::vec3 point(corner & 1 ? local.max.x : local.min.x, corner & 2 ? local.max.y : local.min.y, corner & 4 ? local.max.z : local.min.z);
+		glm::vec3 transformed = glm::vec3(model * glm::vec4(point, 1.0f));
+		world.min = glm::min(world.min, transformed);
+		world.max = glm::max(world.max, transformed);
+	}
+	return world;
+}
+
+std::string Primitives::generateGLSL()
+{
+	std::string functions = "// Generated from the primitive registry in Primitives.cpp\n\n";
+	std::string dispatch = "float primitiveSDF(vec3 p, int type, vec4 a, vec4 b) {\n\tswitch (type) {\n";
+
+	const std::vector<PrimitiveType>& all = registry();
+	for (int i = 0; i < all.size(); ++i) {
+		std::string name = all[i].name;
+		name[0] = static_cast<char>(std::tolower(static_cast<unsigned char>(name[0])));
+		name += "SDF";
+
+		std::string body;
+		size_t start = 0;
+		while (start < all[i].glsl.size()) {
+			size_t end = all[i].glsl.find('\n', start);
+			if (end == std::string::npos) end = all[i].glsl.size();
+			body += "\t" + all[i].glsl.substr(start, end - start) + "\n";
+			start = end + 1;
+		}
+
+		functions += "float " + name + "(vec3 p, vec4 a, vec4 b) {\n" + body + "}\n\n";
+		dispatch += "\t\tcase " + std::to_string(i) + ": return " + name + "(p, a, b);\n";
+	}
+
+	return functions + dispatch + "\t}\n\treturn MAX_DIST;\n}\n";
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+struct Bounds {
+	glm::vec3 min = glm::vec3(0.0f);
+	glm::vec3 max = glm::vec3(0.0f);
+};
+
+// A primitive type is declared once in the registry: its parameters, GLSL and C++ distance
+// functions and bounds. The GPU upload, the generated Primitives.glsl, the GUI and the
+// scene files all go through the registry, so new types need no other changes.
+// Sphere, Cube and Capsule are deliberately not in it: they have analytic ray intersections
+// (analyticHit() in RayMarching.glsl) and compact structs of their own (32, 96 and 112
+// bytes against 144), and their scene file sections predate the registry
+struct PrimitiveType {
+	std::string name;
+	// Names of the used parameters, in the order a.x, a.y, a.z, a.w, b.x, ..., b.w
+	std::vector<std::string> params;
+	glm::vec4 defaultA = glm::vec4(0.0f);
+	glm::vec4 defaultB = glm::vec4(0.0f);
+
+	// Body of 'float sdf(vec3 p, vec4 a, vec4 b)', with p in the primitive's local space
+	std::string glsl;
+	// The same function on the CPU
+	float (*sdf)(glm::vec3 p, glm::vec4 a, glm::vec4 b) = nullptr;
+	// Local space box around the surface
+	Bounds (*bounds)(glm::vec4 a, glm::vec4 b) = nullptr;
+};
+
+struct Primitive {
+	int type = 0;
+	glm::vec3 center = glm::vec3(0.0f);
+	glm::vec3 rotation = glm::vec3(0.0f);
+
+	// Parameters, their meaning comes from the type
+	glm::vec4 a = glm::vec4(0.0f);
+	glm::vec4 b = glm::vec4(0.0f);
+	glm::vec3 color = glm::vec3(1.0f);
+	float reflection = 0.0f;
+
+	bool operator==(const Primitive&) const = default;
+};
+
+glm::mat4 getMatrix(const Primitive& primitive);
+
+namespace Primitives {
+	constexpr int MAX_PARAMS = 8;
+
+	// Built in types first, registerType() adds more before the shaders are built
+	const std::vector<PrimitiveType>& types();
+	int registerType(PrimitiveType type);
+	// -1 when no type has that name
+	int find(const std::string& name);
+
+	Primitive create(int type);
+	float& param(Primitive& primitive, int index);
+
+	float distance(const Primitive& primitive, glm::vec3 pos);
+	Bounds worldBounds(const Primitive& primitive);
+
+	// Contents of the Primitives.glsl include: one distance function per type and
+	// primitiveSDF() switching between them
+	std::string generateGLSL();
+}
@@ -0,0 +1,16 @@
+#include "RenderSettings.hpp"
+
+void RenderSettings::update(Shader& shader)
+{
+	shader.setInt("maxBounces", maxBounces);
+	shader.setInt("stepBudget", stepBudget);
+	shader.setFloat("minReflectance", minReflectance);
+	shader.setBool("cheapBounceLighting", cheapBounceLighting);
+	shader.setBool("useAnalytic", analyticHits);
+	shader.setFloat("lodEpsilon", lodEpsilon);
+	shader.setFloat("lodPixels", lodPixels);
+	shader.setFloat("lodShadeDistance", lodShadeDistance);
+	shader.setInt("shadingScale", shadingScale);
+	shader.setFloat("taaBlend", taaBlend);
+	shader.setFloat("varianceGamma", varianceGamma);
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "Shaders/Shader.hpp"
+
+enum class RenderMode {
+	Fragment, // Full-screen quad, everything in Shader.frag
+	Compute, // Persistent-thread compute shader over screen tiles
+	Wavefront, // Primary pass, then compacted shadow and reflection ray queues
+	ReducedShading, // Full resolution hits, shading at 1/shadingScale resolution then upsampled
+	Checkerboard, // Half the pixels marched per frame, the rest reprojected from the last frame
+	TAA, // Sub-pixel jittered rays accumulated over frames
+	Count
+};
+
+inline const char* RenderModeNames[] = { "Fragment", "Compute", "Wavefront", "Reduced Shading", "Checkerboard", "TAA" };
+
+// How sceneDist() finds the static objects near a point
+enum class SceneLookup {
+	Linear, // Every object at every step
+	Grid, // Only the objects listed in the current cell, see UniformGrid
+	Count
+};
+
+inline const char* SceneLookupNames[] = { "Linear", "Grid" };
+
+class RenderSettings {
+public:
+	RenderMode mode = RenderMode::Fragment;
+	int computeGroups = 256; // Persistent work groups dispatched by the compute path
+	int shadingScale = 2; // 2 or 4, resolution divider of the reduced shading mode
+
+	// March limits, sent with the rest of the frame uniforms
+	float maxDist = 50.0f; // Rays stop past this
+	float maxShadowDist = 25.0f;
+	float surfaceEpsilon = 0.01f; // Fixed hit tolerance, see lodEpsilon
+
+	// Temporal anti-aliasing
+	float taaBlend = 0.1f; // Weight of the newest frame in the history
+	float varianceGamma = 1.0f; // Size of the neighborhood box the history is clipped to, in standard deviations
+
+	// Reflections
+	int maxBounces = 1;
+	int stepBudget = 512; // March steps per pixel, shared by the primary ray and all bounces
+	float minReflectance = 0.05f; // Stop bouncing once the remaining reflected energy is below this
+	bool cheapBounceLighting = false; // Skip shadows on secondary bounces
+
+	// Level of detail
+	float lodEpsilon = 1.0f; // Hit tolerance in pixels at the hit distance, 0 keeps the fixed tolerance
+	float lodPixels = 1.0f; // Bounding radius in pixels under which objects and CSG children become their bounds, 0 disables
+	float lodShadeDistance = 35.0f; // Hits farther than this skip shadows and reflections
+
+	// Step with the baked brick map away from the static objects, see BrickMap
+	bool useBrickMap = false;
+	SceneLookup lookup = SceneLookup::Linear;
+	// Primary rays only march the objects culled for their screen tile, see TileCulling
+	bool tileCulling = false;
+	// Spheres, cubes without rounding and capsules are intersected in closed form, only the rest is marched
+	bool analyticHits = false;
+
+	void update(Shader& shader);
+};
@@ -0,0 +1,409 @@
+#include "Renderer.hpp"
+#include <utility>
+
+static unsigned int createImage(GLenum format, int width, int height, GLenum filter = GL_NEAREST)
+{
+	unsigned int texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, format, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return texture;
+}
+
+Renderer::Renderer(const std::string& shaderDir)
+	: quadShader(shaderDir + "Shader.vert", shaderDir + "Shader.frag"),
+	computeShader(shaderDir + "RayMarch.comp"),
+	wavefrontPrimary(shaderDir + "WavefrontPrimary.comp"),
+	wavefrontShadow(shaderDir + "WavefrontShadow.comp"),
+	wavefrontReflect(shaderDir + "WavefrontReflect.comp"),
+	wavefrontResolve(shaderDir + "WavefrontResolve.comp"),
+	reducedGBuffer(shaderDir + "ReducedGBuffer.comp"),
+	reducedShade(shaderDir + "ReducedShade.comp"),
+	reducedUpsample(shaderDir + "ReducedUpsample.comp"),
+	checkerboardMarch(shaderDir + "CheckerboardMarch.comp"),
+	checkerboardResolve(shaderDir + "CheckerboardResolve.comp"),
+	taaMarch(shaderDir + "TAAMarch.comp"),
+	taaResolve(shaderDir + "TAAResolve.comp")
+{
+	passes[(size_t)RenderMode::Fragment] = { &quadShader };
+	passes[(size_t)RenderMode::Compute] = { &computeShader };
+	passes[(size_t)RenderMode::Wavefront] = { &wavefrontPrimary, &wavefrontShadow, &wavefrontReflect, &wavefrontResolve };
+	passes[(size_t)RenderMode::ReducedShading] = { &reducedGBuffer, &reducedShade, &reducedUpsample };
+	passes[(size_t)RenderMode::Checkerboard] = { &checkerboardMarch, &checkerboardResolve };
+	passes[(size_t)RenderMode::TAA] = { &taaMarch, &taaResolve };
+
+	constexpr float size = 1.0f;
+	float vertices[] = {
+		-size, -size, 0.0f, // Bottom right
+		size, -size, 0.0f, // Bottom left
+		size,  size, 0.0f, // Top left
+		-size,  size, 0.0f // Top Right
+	};
+
+	unsigned int indices[] = {
+		0, 1, 2,
+		2, 3, 0
+	};
+
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+	glGenBuffers(1, &EBO);
+
+	glBindVertexArray(VAO);
+
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+
+	glBindVertexArray(0);
+
+	glGenBuffers(1, &tileCounter);
+	glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, tileCounter);
+	glBufferData(GL_ATOMIC_COUNTER_BUFFER, sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, 0);
+
+	glGenFramebuffers(1, &outputFBO);
+
+	glGenBuffers(1, &accumBuffer);
+	glGenBuffers(1, &shadowQueue);
+	glGenBuffers(2, reflectionQueues);
+}
+
+const std::vector<Shader*>& Renderer::getShaders(RenderMode mode) const
+{
+	return passes[(size_t)mode];
+}
+
+std::vector<Shader*> Renderer::getAllShaders() const
+{
+	std::vector<Shader*> shaders;
+	for (const std::vector<Shader*>& modePasses : passes)
+		shaders.insert(shaders.end(), modePasses.begin(), modePasses.end());
+	return shaders;
+}
+
+void Renderer::render(const RenderSettings& settings, const LightingSystem& lightSys)
+{
+	// History left by another mode can't be reprojected
+	historyValid = historyValid && settings.mode == lastMode;
+	lastMode = settings.mode;
+
+	switch (settings.mode) {
+	case RenderMode::Compute:
+		renderCompute(settings);
+		break;
+	case RenderMode::Wavefront:
+		renderWavefront(settings, lightSys);
+		break;
+	case RenderMode::ReducedShading:
+		renderReducedShading(settings);
+		break;
+	case RenderMode::Checkerboard:
+		renderCheckerboard();
+		break;
+	case RenderMode::TAA:
+		renderTAA();
+		break;
+	default:
+		renderQuad();
+		break;
+	}
+
+	++frameIndex;
+}
+
+void Renderer::renderQuad()
+{
+	glBindVertexArray(VAO);
+	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+}
+
+void Renderer::renderCompute(const RenderSettings& settings)
+{
+	resizeOutput(SCR_WIDTH, SCR_HEIGHT);
+	if (outputWidth == 0 || outputHeight == 0) return;
+
+	// The tile queue restarts at 0 every frame
+	GLuint zero = 0;
+	glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, tileCounter);
+	glBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, sizeof(GLuint), &zero);
+
+	glBindImageTexture(0, outputTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+	glDispatchCompute(settings.computeGroups, 1, 1);
+	glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT);
+
+	blitOutput();
+}
+
+// Empties a ray queue: count 0 and indirect dispatch arguments (0, 1, 1)
+static void resetQueue(unsigned int queue)
+{
+	const GLuint header[4] = { 0, 0, 1, 1 };
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, queue);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(header), header);
+}
+
+void Renderer::renderWavefront(const RenderSettings& settings, const LightingSystem& lightSys)
+{
+	resizeOutput(SCR_WIDTH, SCR_HEIGHT);
+	if (outputWidth == 0 || outputHeight == 0) return;
+
+	// One shadow ray per light and hit at most, the directional light included
+	resizeQueues(outputWidth * outputHeight, (int)lightSys.pointLights.size() + 1);
+
+	// The last frame's passes may still be writing the headers
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	int in = 0, out = 1;
+	resetQueue(shadowQueue);
+	resetQueue(reflectionQueues[out]);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, accumBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, shadowQueue);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, reflectionQueues[in]);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, reflectionQueues[out]);
+
+	wavefrontPrimary.use();
+	wavefrontPrimary.setInt("shadowCapacity", shadowCapacity);
+	wavefrontPrimary.setInt("reflectionCapacity", reflectionCapacity);
+	wavefrontPrimary.setInt("bounce", 0);
+	glDispatchCompute((outputWidth + 7) / 8, (outputHeight + 7) / 8, 1);
+
+	for (int bounce = 0; ; ++bounce) {
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+		// Shadow rays spawned by the last pass, the queue header holds the group count
+		wavefrontShadow.use();
+		wavefrontShadow.setInt("shadowCapacity", shadowCapacity);
+		glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, shadowQueue);
+		glDispatchComputeIndirect(sizeof(GLuint));
+		// resetQueue() overwrites headers the passes just counted with atomics
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+		if (bounce >= settings.maxBounces) break;
+
+		// Reflection rays spawned by the last pass become the input queue
+		std::swap(in, out);
+		resetQueue(shadowQueue);
+		resetQueue(reflectionQueues[out]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, reflectionQueues[in]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, reflectionQueues[out]);
+
+		wavefrontReflect.use();
+		wavefrontReflect.setInt("shadowCapacity", shadowCapacity);
+		wavefrontReflect.setInt("reflectionCapacity", reflectionCapacity);
+		wavefrontReflect.setInt("bounce", bounce + 1);
+		glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, reflectionQueues[in]);
+		glDispatchComputeIndirect(sizeof(GLuint));
+	}
+
+	wavefrontResolve.use();
+	glBindImageTexture(0, outputTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+	glDispatchCompute((outputWidth + 7) / 8, (outputHeight + 7) / 8, 1);
+	glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	blitOutput();
+}
+
+void Renderer::renderReducedShading(const RenderSettings& settings)
+{
+	resizeOutput(SCR_WIDTH, SCR_HEIGHT);
+	if (outputWidth == 0 || outputHeight == 0) return;
+	resizeGBuffer(settings.shadingScale);
+
+	int lowWidth = (outputWidth + lowScale - 1) / lowScale;
+	int lowHeight = (outputHeight + lowScale - 1) / lowScale;
+
+	glBindImageTexture(0, outputTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+	glBindImageTexture(1, gPosition, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F);
+	glBindImageTexture(2, gObject, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32I);
+	glBindImageTexture(3, lowColor, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA16F);
+
+	reducedGBuffer.use();
+	glDispatchCompute((outputWidth + 7) / 8, (outputHeight + 7) / 8, 1);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+	reducedShade.use();
+	glDispatchCompute((lowWidth + 7) / 8, (lowHeight + 7) / 8, 1);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+	reducedUpsample.use();
+	glDispatchCompute((outputWidth + 7) / 8, (outputHeight + 7) / 8, 1);
+	glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT);
+
+	blitOutput();
+}
+
+void Renderer::renderCheckerboard()
+{
+	resizeOutput(SCR_WIDTH, SCR_HEIGHT);
+	if (outputWidth == 0 || outputHeight == 0) return;
+	resizeTemporal();
+
+	int read = historyIndex;
+	int write = 1 - historyIndex;
+
+	glBindImageTexture(0, outputTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+	glBindImageTexture(1, temporalCurrent, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA16F);
+	glBindImageTexture(2, history[write], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, history[read]);
+
+	// Only one pixel out of two per row gets a thread
+	checkerboardMarch.use();
+	glDispatchCompute(((outputWidth + 1) / 2 + 7) / 8, (outputHeight + 7) / 8, 1);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+	checkerboardResolve.use();
+	checkerboardResolve.setBool("historyValid", historyValid);
+	glDispatchCompute((outputWidth + 7) / 8, (outputHeight + 7) / 8, 1);
+	glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	historyIndex = write;
+	historyValid = true;
+
+	blitOutput();
+}
+
+// Radical inverse of index in the given base, in [0, 1)
+static float halton(int index, int base)
+{
+	float result = 0.0f;
+	float fraction = 1.0f;
+	while (index > 0) {
+		fraction /= base;
+		result += fraction * (index % base);
+		index /= base;
+	}
+	return result;
+}
+
+void Renderer::renderTAA()
+{
+	resizeOutput(SCR_WIDTH, SCR_HEIGHT);
+	if (outputWidth == 0 || outputHeight == 0) return;
+	resizeTemporal();
+
+	int read = historyIndex;
+	int write = 1 - historyIndex;
+
+	// Halton (2, 3) over 16 frames, centered on the pixel
+	int sample = frameIndex % 16 + 1;
+	glm::vec2 jitter = { halton(sample, 2) - 0.5f, halton(sample, 3) - 0.5f };
+
+	glBindImageTexture(0, outputTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+	glBindImageTexture(1, temporalCurrent, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA16F);
+	glBindImageTexture(2, history[write], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+	glBindImageTexture(3, motion, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RG16F);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, history[read]);
+
+	taaMarch.use();
+	taaMarch.setVec2("jitter", jitter);
+	glDispatchCompute((outputWidth + 7) / 8, (outputHeight + 7) / 8, 1);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+	taaResolve.use();
+	taaResolve.setBool("historyValid", historyValid);
+	glDispatchCompute((outputWidth + 7) / 8, (outputHeight + 7) / 8, 1);
+	glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	historyIndex = write;
+	historyValid = true;
+
+	blitOutput();
+}
+
+// Sized from the current output, rebuilt whenever the output or the scale changes
+void Renderer::resizeGBuffer(int scale)
+{
+	if (gPosition != 0 && scale == lowScale) return;
+	lowScale = scale;
+
+	unsigned int textures[] = { gPosition, gObject, lowColor };
+	glDeleteTextures(3, textures);
+
+	gPosition = createImage(GL_RGBA32F, outputWidth, outputHeight);
+	gObject = createImage(GL_R32I, outputWidth, outputHeight);
+	lowColor = createImage(GL_RGBA16F, (outputWidth + scale - 1) / scale, (outputHeight + scale - 1) / scale);
+}
+
+void Renderer::resizeTemporal()
+{
+	if (temporalCurrent != 0) return;
+
+	temporalCurrent = createImage(GL_RGBA16F, outputWidth, outputHeight);
+	history[0] = createImage(GL_RGBA16F, outputWidth, outputHeight, GL_LINEAR);
+	history[1] = createImage(GL_RGBA16F, outputWidth, outputHeight, GL_LINEAR);
+	motion = createImage(GL_RG16F, outputWidth, outputHeight);
+	historyValid = false;
+}
+
+void Renderer::resizeQueues(int pixels, int shadowRaysPerPixel)
+{
+	if (reflectionCapacity == pixels && shadowCapacity == pixels * shadowRaysPerPixel) return;
+	reflectionCapacity = pixels;
+	shadowCapacity = pixels * shadowRaysPerPixel;
+
+	// Header of 4 uints, then the rays (48 bytes each, see Wavefront.glsl)
+	constexpr GLsizeiptr header = 4 * sizeof(GLuint);
+	constexpr GLsizeiptr raySize = 12 * sizeof(float);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, shadowQueue);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, header + shadowCapacity * raySize, nullptr, GL_DYNAMIC_DRAW);
+	for (unsigned int queue : reflectionQueues) {
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, queue);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, header + reflectionCapacity * raySize, nullptr, GL_DYNAMIC_DRAW);
+	}
+
+	// The resolve pass clears the accumulation after reading it, so it only starts zeroed
+	const GLuint zero = 0;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, accumBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, 3 * pixels * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+	glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void Renderer::blitOutput()
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, outputFBO);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, outputWidth, outputHeight, 0, 0, outputWidth, outputHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Renderer::resizeOutput(int width, int height)
+{
+	if (width == outputWidth && height == outputHeight) return;
+	outputWidth = width;
+	outputHeight = height;
+
+	if (outputTexture != 0) glDeleteTextures(1, &outputTexture);
+	outputTexture = 0;
+
+	// Screen sized buffers of the other paths follow the output
+	unsigned int textures[] = { gPosition, gObject, lowColor, temporalCurrent, history[0], history[1], motion };
+	glDeleteTextures(7, textures);
+	gPosition = gObject = lowColor = 0;
+	temporalCurrent = history[0] = history[1] = motion = 0;
+
+	if (width == 0 || height == 0) return;
+
+	outputTexture = createImage(GL_RGBA8, width, height);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, outputTexture, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <glad/glad.h>
+#include <string>
+#include <array>
+#include <vector>
+#include "IO/Input.hpp"
+#include "Shaders/Shader.hpp"
+#include "RenderSettings.hpp"
+#include "LightingSystem.hpp"
+
+class Renderer {
+public:
+	Shader quadShader;
+	Shader computeShader;
+	Shader wavefrontPrimary;
+	Shader wavefrontShadow;
+	Shader wavefrontReflect;
+	Shader wavefrontResolve;
+	Shader reducedGBuffer;
+	Shader reducedShade;
+	Shader reducedUpsample;
+	Shader checkerboardMarch;
+	Shader checkerboardResolve;
+	Shader taaMarch;
+	Shader taaResolve;
+
+private:
+	// Programs each mode runs, all of them need the scene uniforms
+	std::array<std::vector<Shader*>, (size_t)RenderMode::Count> passes;
+
+	unsigned int VAO = 0, VBO = 0, EBO = 0;
+
+	// Compute path output, blitted to the default framebuffer
+	unsigned int outputTexture = 0;
+	unsigned int outputFBO = 0;
+	unsigned int tileCounter = 0;
+	int outputWidth = 0;
+	int outputHeight = 0;
+
+	// Wavefront path
+	unsigned int accumBuffer = 0;
+	unsigned int shadowQueue = 0;
+	unsigned int reflectionQueues[2] = { 0, 0 };
+	int shadowCapacity = 0;
+	int reflectionCapacity = 0;
+
+	// Reduced shading path
+	unsigned int gPosition = 0;
+	unsigned int gObject = 0;
+	unsigned int lowColor = 0;
+	int lowScale = 0;
+
+	// Temporal paths, history is ping-ponged between frames
+	unsigned int temporalCurrent = 0;
+	unsigned int history[2] = { 0, 0 };
+	unsigned int motion = 0;
+	int historyIndex = 0;
+	bool historyValid = false;
+	int frameIndex = 0;
+	RenderMode lastMode = RenderMode::Count;
+
+public:
+	Renderer(const std::string& shaderDir);
+	Renderer(const Renderer&) = delete;
+	Renderer& operator=(const Renderer&) = delete;
+
+	const std::vector<Shader*>& getShaders(RenderMode mode) const;
+	std::vector<Shader*> getAllShaders() const;
+	void render(const RenderSettings& settings, const LightingSystem& lightSys);
+	// Index of the frame the next render() draws
+	int getFrameIndex() const { return frameIndex; }
+
+private:
+	void renderQuad();
+	void renderCompute(const RenderSettings& settings);
+	void renderWavefront(const RenderSettings& settings, const LightingSystem& lightSys);
+	void renderReducedShading(const RenderSettings& settings);
+	void renderCheckerboard();
+	void renderTAA();
+	void resizeOutput(int width, int height);
+	void resizeQueues(int pixels, int shadowRaysPerPixel);
+	void resizeGBuffer(int scale);
+	void resizeTemporal();
+	void blitOutput();
+};
@@ -0,0 +1,337 @@
+#include "Scene.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <type_traits>
+#include "IO/MappedFile.hpp"
+
+namespace {
+	struct SceneCamera {
+		glm::vec3 position;
+		float yaw;
+		float pitch;
+	};
+
+	// Everything a scene file holds, parsed before anything is replaced
+	struct SceneData {
+		SceneCamera camera;
+		DirectionalLight dirLight;
+		std::vector<PointLight> pointLights;
+		std::vector<Sphere> spheres;
+		std::vector<Cube> cubes;
+		std::vector<Capsule> capsules;
+		std::vector<Primitive> primitives;
+	};
+
+#pragma region Binary
+	constexpr char MAGIC[4] = { 'R', 'M', 'S', 'B' };
+	// Offsets are kept aligned so the mapped arrays can be read in place
+	constexpr uint64_t SECTION_ALIGNMENT = 16;
+
+	enum Section : uint32_t {
+		CAMERA,
+		DIRLIGHT,
+		POINTLIGHTS,
+		SPHERES,
+		CUBES,
+		CAPSULES,
+		PRIMITIVES,
+		SECTION_COUNT
+	};
+
+	struct SectionHeader {
+		uint64_t offset;
+		uint32_t count;
+		// Element size when the file was written, a mismatch means the structs changed
+		uint32_t stride;
+	};
+
+	struct BinaryHeader {
+		char magic[4];
+		uint32_t version;
+		SectionHeader sections[SECTION_COUNT];
+	};
+
+	static_assert(std::is_trivially_copyable_v<SceneCamera> && std::is_trivially_copyable_v<DirectionalLight>
+		&& std::is_trivially_copyable_v<PointLight> && std::is_trivially_copyable_v<Sphere>
+		&& std::is_trivially_copyable_v<Cube> && std::is_trivially_copyable_v<Capsule> && std::is_trivially_copyable_v<Primitive>,
+		"Binary scenes copy the structs as raw bytes");
+
+	// Turns a section's offset into a pointer into the mapping, nullptr if it doesn't fit the file
+	template<typename T>
+	const T* fixup(const IO::MappedFile& file, const SectionHeader& section)
+	{
+		if (section.stride != sizeof(T) || section.offset % alignof(T) != 0) return nullptr;
+		uint64_t bytes = static_cast<uint64_t>(section.count) * sizeof(T);
+		if (section.offset > file.size() || bytes > file.size() - section.offset) return nullptr;
+		return reinterpret_cast<const T*>(file.data() + section.offset);
+	}
+
+	template<typename T>
+	bool readArray(const IO::MappedFile& file, const SectionHeader& section, std::vector<T>& out)
+	{
+		const T* data = fixup<T>(file, section);
+		if (data == nullptr) return false;
+		out.assign(data, data + section.count);
+		return true;
+	}
+
+	template<typename T>
+	bool readSingle(const IO::MappedFile& file, const SectionHeader& section, T& out)
+	{
+		const T* data = fixup<T>(file, section);
+		if (data == nullptr || section.count != 1) return false;
+		std::memcpy(&out, data, sizeof(T));
+		return true;
+	}
+
+	bool loadBinary(const std::string& path, SceneData& scene)
+	{
+		IO::MappedFile file(path);
+		if (!file.isOpen()) {
+			std::cerr << "ERROR::SCENE::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+			return false;
+		}
+
+		BinaryHeader header{};
+		constexpr size_t prefix = offsetof(BinaryHeader, sections);
+		if (file.size() < prefix) {
+			std::cerr << "ERROR::SCENE::TRUNCATED_HEADER: " << path << std::endl;
+			return false;
+		}
+		std::memcpy(&header, file.data(), prefix);
+		if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version < 1 || header.version > Scene::VERSION) {
+			std::cerr << "ERROR::SCENE::UNSUPPORTED_FORMAT: " << path << std::endl;
+			return false;
+		}
+
+		// Version 1 had no PRIMITIVES section, its header ends before it
+		int sectionCount = header.version == 1 ? PRIMITIVES : SECTION_COUNT;
+		if (file.size() < prefix + sectionCount * sizeof(SectionHeader)) {
+			std::cerr << "ERROR::SCENE::TRUNCATED_HEADER: " << path << std::endl;
+			return false;
+		}
+		std::memcpy(header.sections, file.data() + prefix, sectionCount * sizeof(SectionHeader));
+
+		const SectionHeader* sections = header.sections;
+		bool ok = readSingle(file, sections[CAMERA], scene.camera)
+			&& readSingle(file, sections[DIRLIGHT], scene.dirLight)
+			&& readArray(file, sections[POINTLIGHTS], scene.pointLights)
+			&& readArray(file, sections[SPHERES], scene.spheres)
+			&& readArray(file, sections[CUBES], scene.cubes)
+			&& readArray(file, sections[CAPSULES], scene.capsules)
+			&& (sectionCount <= PRIMITIVES || readArray(file, sections[PRIMITIVES], scene.primitives));
+		// Types are stored as registry indices
+		for (const Primitive& primitive : scene.primitives)
+			ok &= primitive.type >= 0 && primitive.type < Primitives::types().size();
+		if (!ok) std::cerr << "ERROR::SCENE::CORRUPT_SECTION: " << path << std::endl;
+		return ok;
+	}
+
+	bool saveBinary(const std::string& path, const SceneData& scene)
+	{
+		BinaryHeader header{};
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = Scene::VERSION;
+
+		struct Block { const void* data; uint32_t count; uint32_t stride; };
+		Block blocks[SECTION_COUNT] = {
+			{ &scene.camera, 1, sizeof(SceneCamera) },
+			{ &scene.dirLight, 1, sizeof(DirectionalLight) },
+			{ scene.pointLights.data(), (uint32_t)scene.pointLights.size(), sizeof(PointLight) },
+			{ scene.spheres.data(), (uint32_t)scene.spheres.size(), sizeof(Sphere) },
+			{ scene.cubes.data(), (uint32_t)scene.cubes.size(), sizeof(Cube) },
+			{ scene.capsules.data(), (uint32_t)scene.capsules.size(), sizeof(Capsule) },
+			{ scene.primitives.data(), (uint32_t)scene.primitives.size(), sizeof(Primitive) },
+		};
+
+		uint64_t offset = sizeof(header);
+		for (int i = 0; i < SECTION_COUNT; ++i) {
+			offset = (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+			header.sections[i] = { offset, blocks[i].count, blocks[i].stride };
+			offset += static_cast<uint64_t>(blocks[i].count) * blocks[i].stride;
+		}
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			std::cerr << "ERROR::SCENE::FILE_NOT_SUCCESSFULLY_WRITTEN: " << path << std::endl;
+			return false;
+		}
+
+		const char padding[SECTION_ALIGNMENT] = {};
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		uint64_t written = sizeof(header);
+		for (int i = 0; i < SECTION_COUNT; ++i) {
+			file.write(padding, header.sections[i].offset - written);
+			uint64_t bytes = static_cast<uint64_t>(blocks[i].count) * blocks[i].stride;
+			if (bytes > 0) file.write(static_cast<const char*>(blocks[i].data), bytes);
+			written = header.sections[i].offset + bytes;
+		}
+		return static_cast<bool>(file);
+	}
+#pragma endregion
+
+#pragma region Text
+	/* One entry per line, fields in the same order as the structs:
+	* camera     position(3) yaw pitch
+	* dirlight   direction(3) ambient(3) diffuse(3) specular(3) color(3)
+	* pointlight position(3) ambient(3) diffuse(3) specular(3) color(3) constant linear quadratic
+	* sphere     radius center(3) color(3) reflection
+	* cube       center(3) rotation(3) size(3) color(3) reflection rounding
+	* capsule    center(3) rotation(3) pos1(3) pos2(3) color(3) reflection radius
+	* primitive  type center(3) rotation(3) params(as many as the type has) color(3) reflection
+	*/
+	std::istream& operator>>(std::istream& in, glm::vec3& v)
+	{
+		return in >> v.x >> v.y >> v.z;
+	}
+
+	std::ostream& operator<<(std::ostream& out, const glm::vec3& v)
+	{
+		return out << v.x << ' ' << v.y << ' ' << v.z;
+	}
+
+	bool parseLine(const std::string& type, std::istringstream& in, SceneData& scene)
+	{
+		if (type == "camera") {
+			SceneCamera& c = scene.camera;
+			in >> c.position >> c.yaw >> c.pitch;
+		}
+		else if (type == "dirlight") {
+			DirectionalLight& l = scene.dirLight;
+			in >> l.direction >> l.ambient >> l.diffuse >> l.specular >> l.color;
+		}
+		else if (type == "pointlight") {
+			PointLight l;
+			in >> l.position >> l.ambient >> l.diffuse >> l.specular >> l.color >> l.constant >> l.linear >> l.quadratic;
+			scene.pointLights.push_back(l);
+		}
+		else if (type == "sphere") {
+			Sphere s;
+			in >> s.radius >> s.center >> s.color >> s.reflection;
+			scene.spheres.push_back(s);
+		}
+		else if (type == "cube") {
+			Cube c;
+			in >> c.center >> c.rotation >> c.size >> c.color >> c.reflection >> c.rounding;
+			scene.cubes.push_back(c);
+		}
+		else if (type == "capsule") {
+			Capsule c;
+			in >> c.center >> c.rotation >> c.pos1 >> c.pos2 >> c.color >> c.reflection >> c.radius;
+			scene.capsules.push_back(c);
+		}
+		else if (type == "primitive") {
+			std::string name;
+			in >> name;
+			int index = Primitives::find(name);
+			if (index < 0) return false;
+
+			Primitive p = Primitives::create(index);
+			in >> p.center >> p.rotation;
+			for (int i = 0; i < Primitives::types()[index].params.size(); ++i) in >> Primitives::param(p, i);
+			in >> p.color >> p.reflection;
+			scene.primitives.push_back(p);
+		}
+		else return false;
+
+		return !in.fail();
+	}
+
+	bool loadText(const std::string& path, SceneData& scene)
+	{
+		std::ifstream file(path);
+		if (!file) {
+			std::cerr << "ERROR::SCENE::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+			return false;
+		}
+
+		std::string line;
+		std::string type;
+		unsigned int version = 0;
+		if (!std::getline(file, line) || !(std::istringstream(line) >> type >> version) || type != "raymarching-scene" || version < 1 || version > Scene::VERSION) {
+			std::cerr << "ERROR::SCENE::UNSUPPORTED_FORMAT: " << path << std::endl;
+			return false;
+		}
+
+		for (int lineNumber = 2; std::getline(file, line); ++lineNumber) {
+			line = line.substr(0, line.find('#'));
+			std::istringstream in(line);
+			if (!(in >> type)) continue;
+
+			if (!parseLine(type, in, scene)) {
+				std::cerr << "ERROR::SCENE::PARSE_ERROR: " << path << ":" << lineNumber << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool saveText(const std::string& path, const SceneData& scene)
+	{
+		std::ofstream file(path, std::ios::trunc);
+		if (!file) {
+			std::cerr << "ERROR::SCENE::FILE_NOT_SUCCESSFULLY_WRITTEN: " << path << std::endl;
+			return false;
+		}
+
+		const SceneCamera& c = scene.camera;
+		const DirectionalLight& d = scene.dirLight;
+		file << "raymarching-scene " << Scene::VERSION << '\n';
+		file << "camera " << c.position << ' ' << c.yaw << ' ' << c.pitch << '\n';
+		file << "dirlight " << d.direction << ' ' << d.ambient << ' ' << d.diffuse << ' ' << d.specular << ' ' << d.color << '\n';
+
+		for (const PointLight& l : scene.pointLights)
+			file << "pointlight " << l.position << ' ' << l.ambient << ' ' << l.diffuse << ' ' << l.specular << ' ' << l.color << ' '
+				<< l.constant << ' ' << l.linear << ' ' << l.quadratic << '\n';
+		for (const Sphere& s : scene.spheres)
+			file << "sphere " << s.radius << ' ' << s.center << ' ' << s.color << ' ' << s.reflection << '\n';
+		for (const Cube& b : scene.cubes)
+			file << "cube " << b.center << ' ' << b.rotation << ' ' << b.size << ' ' << b.color << ' ' << b.reflection << ' ' << b.rounding << '\n';
+		for (const Capsule& p : scene.capsules)
+			file << "capsule " << p.center << ' ' << p.rotation << ' ' << p.pos1 << ' ' << p.pos2 << ' ' << p.color << ' '
+				<< p.reflection << ' ' << p.radius << '\n';
+		for (Primitive p : scene.primitives) {
+			const PrimitiveType& type = Primitives::types()[p.type];
+			file << "primitive " << type.name << ' ' << p.center << ' ' << p.rotation;
+			for (int i = 0; i < type.params.size(); ++i) file << ' ' << Primitives::param(p, i);
+			file << ' ' << p.color << ' ' << p.reflection << '\n';
+		}
+
+		return static_cast<bool>(file);
+	}
+#pragma endregion
+
+	bool isBinary(const std::string& path)
+	{
+		const std::string extension = ".sceneb";
+		return path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+	}
+}
+
+bool Scene::load(const std::string& path, Objects& objects, LightingSystem& lightSys, Camera& camera)
+{
+	SceneData scene;
+	scene.camera = { camera.Position, camera.Yaw, camera.Pitch };
+	scene.dirLight = lightSys.dirLight;
+
+	if (!(isBinary(path) ? loadBinary(path, scene) : loadText(path, scene))) return false;
+
+	camera.setView(scene.camera.position, scene.camera.yaw, scene.camera.pitch);
+	lightSys.dirLight = scene.dirLight;
+	lightSys.pointLights = std::move(scene.pointLights);
+	objects.spheres = std::move(scene.spheres);
+	objects.cubes = std::move(scene.cubes);
+	objects.capsules = std::move(scene.capsules);
+	objects.primitives = std::move(scene.primitives);
+	return true;
+}
+
+bool Scene::save(const std::string& path, const Objects& objects, const LightingSystem& lightSys, const Camera& camera)
+{
+	SceneData scene{ { camera.Position, camera.Yaw, camera.Pitch }, lightSys.dirLight, lightSys.pointLights, objects.spheres, objects.cubes, objects.capsules, objects.primitives };
+	return isBinary(path) ? saveBinary(path, scene) : saveText(path, scene);
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <string>
+#include "Objects.hpp"
+#include "LightingSystem.hpp"
+#include "Camera.hpp"
+
+// Scene files hold the camera, the lights and the objects.
+// Paths ending in ".sceneb" use the binary format, anything else the text format:
+// - Text: a "raymarching-scene <version>" line, then one line per entry with the fields in struct order
+//   (# starts a comment), see Scene.cpp for each entry
+// - Binary: a header with one section per array, the file is memory mapped and
+//   every section is copied straight into its vector
+namespace Scene {
+	// 2 added primitives from the registry, text files of version 1 still load
+	constexpr unsigned int VERSION = 2;
+
+	// Both return false and leave the scene untouched on failure
+	bool load(const std::string& path, Objects& objects, LightingSystem& lightSys, Camera& camera);
+	bool save(const std::string& path, const Objects& objects, const LightingSystem& lightSys, const Camera& camera);
+}
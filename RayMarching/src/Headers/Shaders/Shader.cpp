@@ -1,119 +1,72 @@
 #include "Shader.hpp"
+#include "EmbeddedShaders.hpp"
 
-Shader::Shader(std::string vertexSrc, std::string fragmentSrc)
+Shader::Shader(std::string vertexSrc, std::string fragmentSrc, Defines defines)
+    : stages{ { GL_VERTEX_SHADER, vertexSrc }, { GL_FRAGMENT_SHADER, fragmentSrc } }, defines(std::move(defines))
 {
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-    // ensure ifstream objects can throw exceptions:
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    try
-    {
-        // open files
-        vShaderFile.open(vertexSrc);
-        fShaderFile.open(fragmentSrc);
-        std::stringstream vShaderStream, fShaderStream;
-        // read file's buffer contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        // close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
-        // convert stream into string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
-    }
-    catch (std::ifstream::failure& e)
-    {
-        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
-    }
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
-
-    unsigned int vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    this->checkCompileErrors(vertex, "VERTEX");
-    unsigned int fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    this->checkCompileErrors(fragment, "FRAGMENT");
+    ID = build(stages, this->defines, dependencies);
+}
 
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
-    checkCompileErrors(ID, "PROGRAM");
+Shader::Shader(std::string vertexSrc, std::string fragmentSrc, std::string geometrySrc, Defines defines)
+    : stages{ { GL_VERTEX_SHADER, vertexSrc }, { GL_FRAGMENT_SHADER, fragmentSrc }, { GL_GEOMETRY_SHADER, geometrySrc } }, defines(std::move(defines))
+{
+    ID = build(stages, this->defines, dependencies);
+}
 
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+Shader::Shader(std::string computeSrc, Defines defines)
+    : stages{ { GL_COMPUTE_SHADER, computeSrc } }, defines(std::move(defines))
+{
+    ID = build(stages, this->defines, dependencies);
 }
 
-Shader::Shader(std::string vertexSrc, std::string fragmentSrc, std::string geometrySrc)
+unsigned int Shader::build(const Stages& stages, const Defines& defines, std::vector<std::string>& dependencies)
 {
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::string geometryCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-    std::ifstream gShaderFile;
-    // ensure ifstream objects can throw exceptions:
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    gShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    try
-    {
-        // open files
-        vShaderFile.open(vertexSrc);
-        fShaderFile.open(fragmentSrc);
-        gShaderFile.open(geometrySrc);
-        std::stringstream vShaderStream, fShaderStream, gShaderStream;
-        // read file's buffer contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        gShaderStream << gShaderFile.rdbuf();
-        // close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
-        gShaderFile.close();
-        // convert stream into string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
-        geometryCode = gShaderStream.str();
-    }
-    catch (std::ifstream::failure& e)
-    {
-        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
-    }
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
-    const char* gShaderCode = geometryCode.c_str();
+    std::vector<std::string> files;
+    std::vector<unsigned int> shaders;
+    bool success = true;
 
-    unsigned int vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    this->checkCompileErrors(vertex, "VERTEX");
-    unsigned int fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    this->checkCompileErrors(fragment, "FRAGMENT");
-    unsigned int geometry = glCreateShader(GL_GEOMETRY_SHADER);
-    glShaderSource(geometry, 1, &gShaderCode, NULL);
-    glCompileShader(geometry);
-    this->checkCompileErrors(geometry, "GEOMETRY");
+    for (const auto& [type, path] : stages) {
+        ShaderPreprocessor preprocessor(readFile);
+        std::string code;
+        try
+        {
+            code = preprocessor.process(path, defines);
+            files.insert(files.end(), preprocessor.files.begin(), preprocessor.files.end());
+        }
+        catch (std::ifstream::failure& e)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << " " << e.what() << std::endl;
+            success = false;
+            break;
+        }
+        const char* shaderCode = code.c_str();
+
+        const char* name = type == GL_VERTEX_SHADER ? "VERTEX"
+            : type == GL_FRAGMENT_SHADER ? "FRAGMENT"
+            : type == GL_GEOMETRY_SHADER ? "GEOMETRY" : "COMPUTE";
+
+        unsigned int shader = glCreateShader(type);
+        glShaderSource(shader, 1, &shaderCode, NULL);
+        glCompileShader(shader);
+        success &= checkCompileErrors(shader, name, &preprocessor);
+        shaders.push_back(shader);
+    }
 
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glAttachShader(ID, geometry);
-    glLinkProgram(ID);
-    checkCompileErrors(ID, "PROGRAM");
+    unsigned int ID = 0;
+    if (success) {
+        ID = glCreateProgram();
+        for (unsigned int shader : shaders) glAttachShader(ID, shader);
+        glLinkProgram(ID);
+        if (!checkCompileErrors(ID, "PROGRAM")) {
+            glDeleteProgram(ID);
+            ID = 0;
+        }
+    }
 
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
-    glDeleteShader(geometry);
+    for (unsigned int shader : shaders) glDeleteShader(shader);
+    // Even a failed build reports its files, so fixing any of them triggers a reload
+    dependencies = std::move(files);
+    return ID;
 }
 
 void Shader::use()
@@ -121,7 +74,7 @@ void Shader::use()
 	glUseProgram(ID);
 }
 
-void Shader::checkCompileErrors(unsigned int shader, std::string type)
+bool Shader::checkCompileErrors(unsigned int shader, std::string type, const ShaderPreprocessor* source)
 {
     int success;
     char infoLog[1024];
@@ -131,7 +84,8 @@ void Shader::checkCompileErrors(unsigned int shader, std::string type)
         if (!success)
         {
             glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-            std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+            std::string log = source ? source->translateLog(infoLog) : infoLog;
+            std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << log << "\n -- --------------------------------------------------- -- " << std::endl;
         }
     }
     else
@@ -143,4 +97,29 @@ void Shader::checkCompileErrors(unsigned int shader, std::string type)
             std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
         }
     }
+    return success;
+}
+
+std::string Shader::readFile(const std::string& path)
+{
+    auto generated = generatedSources.find(std::filesystem::path(path).filename().string());
+    if (generated != generatedSources.end()) return generated->second;
+
+    if (useEmbedded)
+    {
+        std::string name = std::filesystem::path(path).lexically_normal().generic_string();
+        for (const EmbeddedShaders::File& file : EmbeddedShaders::files)
+            if (file.name == name) return std::string(file.source);
+
+        throw std::ifstream::failure("no embedded shader named " + name);
+    }
+
+    std::ifstream file;
+    // ensure ifstream objects can throw exceptions:
+    file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    file.open(path);
+    std::stringstream stream;
+    stream << file.rdbuf();
+    file.close();
+    return stream.str();
 }
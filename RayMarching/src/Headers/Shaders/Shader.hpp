@@ -7,20 +7,46 @@
 
 #include <string>
 #include <fstream>
+#include <filesystem>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "ShaderPreprocessor.hpp"
 
 class Shader {
 public:
+    using Stages = std::vector<std::pair<GLenum, std::string>>;
+    using Defines = ShaderPreprocessor::Defines;
+
     unsigned int ID = 0;
+    // Stage type and path of every source, kept so the program can be rebuilt
+    Stages stages;
+    // Injected into every stage after #version
+    Defines defines;
+    // Every file read by the last build, includes too
+    std::vector<std::string> dependencies;
+
+    // Sources come from the copies tools/embed_shaders.py compiles into the binary,
+    // with paths taken as names in that table. Set to false to read them from disk
+    static inline bool useEmbedded = true;
+    // Files built at runtime (e.g. Primitives.glsl), looked up by file name before anything else
+    static inline std::unordered_map<std::string, std::string> generatedSources;
 
 private:
-    void checkCompileErrors(unsigned int shader, std::string type);
+    static bool checkCompileErrors(unsigned int shader, std::string type, const ShaderPreprocessor* source = nullptr);
+    static std::string readFile(const std::string& path);
 
 public:
     Shader() = default;
-    Shader(std::string vertexSrc, std::string fragmentSrc);
-    Shader(std::string vertexSrc, std::string fragmentSrc, std::string geometrySrc);
+    Shader(std::string vertexSrc, std::string fragmentSrc, Defines defines = {});
+    Shader(std::string vertexSrc, std::string fragmentSrc, std::string geometrySrc, Defines defines = {});
+    explicit Shader(std::string computeSrc, Defines defines = {});
+
+    // Compiles and links the stages, returns 0 on failure after printing the log.
+    // Only needs a current context, so it can run on a loader thread
+    static unsigned int build(const Stages& stages, const Defines& defines, std::vector<std::string>& dependencies);
 
     void use();
 public:
@@ -56,6 +82,10 @@ public:
     {
         glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
     }
+    void setIVec3(const std::string& name, const glm::ivec3& value) const
+    {
+        glUniform3i(glGetUniformLocation(ID, name.c_str()), value.x, value.y, value.z);
+    }
     // ------------------------------------------------------------------------
     void setVec4(const std::string& name, const glm::vec4& value) const
     {
@@ -0,0 +1,109 @@
+#include "ShaderPreprocessor.hpp"
+#include <filesystem>
+#include <regex>
+#include <sstream>
+
+ShaderPreprocessor::ShaderPreprocessor(Reader reader) : reader(std::move(reader))
+{
+}
+
+std::string ShaderPreprocessor::process(const std::string& path, const Defines& defines)
+{
+	files.clear();
+	onceFiles.clear();
+
+	std::string output;
+	expand(path, output, &defines);
+	return output;
+}
+
+static bool isDirective(const std::string& line, size_t start, const char* directive)
+{
+	size_t length = std::char_traits<char>::length(directive);
+	return line.compare(start, length, directive) == 0
+		&& (line.size() == start + length || line[start + length] == ' ' || line[start + length] == '\t');
+}
+
+void ShaderPreprocessor::expand(const std::string& path, std::string& output, const Defines* defines)
+{
+	std::string normalized = std::filesystem::path(path).lexically_normal().string();
+	if (onceFiles.count(normalized)) return;
+
+	const int fileIndex = static_cast<int>(files.size());
+	files.push_back(normalized);
+
+	std::istringstream stream(reader(path));
+	const std::string location = " " + std::to_string(fileIndex) + "\n";
+
+	std::string line;
+	int lineNumber = 0;
+	// Nothing but comments may come before #version, so the root starts without a #line
+	if (fileIndex != 0) output += "#line 1" + location;
+
+	while (std::getline(stream, line))
+	{
+		++lineNumber;
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+
+		size_t start = line.find_first_not_of(" \t");
+		if (start == std::string::npos || line[start] != '#') {
+			output += line + '\n';
+			continue;
+		}
+		size_t directive = line.find_first_not_of(" \t", start + 1);
+		if (directive == std::string::npos) directive = start + 1;
+
+		if (isDirective(line, directive, "include"))
+		{
+			size_t first = line.find('"', directive);
+			size_t last = line.rfind('"');
+			if (first != std::string::npos && last > first)
+			{
+				std::filesystem::path include = std::filesystem::path(path).parent_path() / line.substr(first + 1, last - first - 1);
+				expand(include.string(), output, nullptr);
+				output += "#line " + std::to_string(lineNumber + 1) + location;
+				continue;
+			}
+		}
+		else if (isDirective(line, directive, "pragma") && line.find("once", directive + 6) != std::string::npos)
+		{
+			onceFiles.insert(normalized);
+			output += '\n';
+			continue;
+		}
+		else if (defines != nullptr && isDirective(line, directive, "version"))
+		{
+			output += line + '\n';
+			for (const auto& [name, value] : *defines)
+				output += "#define " + name + " " + value + '\n';
+			output += "#line " + std::to_string(lineNumber + 1) + location;
+			continue;
+		}
+
+		output += line + '\n';
+	}
+}
+
+std::string ShaderPreprocessor::translateLog(const std::string& log) const
+{
+	static const std::regex pattern(R"(^(\s*(?:ERROR|WARNING)?:?\s*)(\d+)(?::(\d+)|\((\d+)\)))");
+
+	std::istringstream stream(log);
+	std::string translated;
+	std::string line;
+	while (std::getline(stream, line))
+	{
+		std::smatch match;
+		if (std::regex_search(line, match, pattern))
+		{
+			size_t file = std::stoul(match[2].str());
+			std::string lineNumber = match[3].matched ? match[3].str() : match[4].str();
+			if (file < files.size()) {
+				translated += match[1].str() + files[file] + ":" + lineNumber + match.suffix().str() + '\n';
+				continue;
+			}
+		}
+		translated += line + '\n';
+	}
+	return translated;
+}
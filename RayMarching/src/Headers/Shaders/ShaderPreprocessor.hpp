@@ -0,0 +1,35 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Expands a shader before it reaches the driver:
+// - '#include "file"' is replaced by the file, resolved relative to the including file
+// - '#pragma once' files are only expanded the first time they are included
+// - defines are injected right after '#version'
+// Every file gets a source string number in '#line' directives, so compiler logs
+// can be mapped back to the original file and line with translateLog()
+class ShaderPreprocessor {
+public:
+	using Defines = std::vector<std::pair<std::string, std::string>>;
+	using Reader = std::function<std::string(const std::string& path)>;
+
+	// Files in source string order, the root file is 0
+	std::vector<std::string> files;
+
+private:
+	Reader reader;
+	std::unordered_set<std::string> onceFiles;
+
+	void expand(const std::string& path, std::string& output, const Defines* defines);
+
+public:
+	explicit ShaderPreprocessor(Reader reader);
+
+	// Throws whatever the reader throws for a missing file
+	std::string process(const std::string& path, const Defines& defines);
+	// Rewrites "0(12)" (NVIDIA) and "0:12" (AMD, Intel, Mesa) locations into "file:12"
+	std::string translateLog(const std::string& log) const;
+};
@@ -0,0 +1,83 @@
+#include "ShaderReloader.hpp"
+#include <algorithm>
+
+ShaderReloader::ShaderReloader(GLFWwindow* window, const std::string& shaderDir, const std::vector<Shader*>& shaders)
+	: watcher(shaderDir)
+{
+	for (Shader* shader : shaders)
+		jobs.push_back({ shader, shader->stages, shader->defines, shader->dependencies });
+
+	// Windows can only be created on the main thread, the loader just makes it current
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	context = glfwCreateWindow(1, 1, "Shader Loader", nullptr, window);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+	if (context == nullptr) {
+		std::cerr << "ERROR::SHADER_RELOADER::CONTEXT_NOT_CREATED, hot reload is disabled" << std::endl;
+		return;
+	}
+
+	loader = std::thread(&ShaderReloader::loop, this);
+}
+
+ShaderReloader::~ShaderReloader()
+{
+	running = false;
+	if (loader.joinable()) loader.join();
+
+	for (Result& result : finished) {
+		glDeleteSync(result.fence);
+		glDeleteProgram(result.program);
+	}
+
+	if (context != nullptr) glfwDestroyWindow(context);
+}
+
+void ShaderReloader::loop()
+{
+	glfwMakeContextCurrent(context);
+
+	while (running) {
+		std::vector<std::string> changed = watcher.wait(100);
+		if (changed.empty()) continue;
+
+		for (Job& job : jobs) {
+			bool dirty = std::any_of(job.dependencies.begin(), job.dependencies.end(), [&](const std::string& file) {
+				return std::find(changed.begin(), changed.end(), file) != changed.end();
+			});
+			if (!dirty) continue;
+
+			unsigned int program = Shader::build(job.stages, job.defines, job.dependencies);
+			if (program == 0) {
+				std::cout << "Keeping the previous program for " << job.stages.back().second << std::endl;
+				continue;
+			}
+
+			// The main context may only use the program once the loader's commands completed
+			GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			glFlush();
+
+			std::lock_guard<std::mutex> lock(mutex);
+			finished.push_back({ job.shader, program, fence });
+		}
+	}
+
+	glfwMakeContextCurrent(nullptr);
+}
+
+void ShaderReloader::update()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// In order, so a newer build of a shader never gets replaced by an older one
+	size_t swapped = 0;
+	for (; swapped < finished.size(); ++swapped) {
+		Result& result = finished[swapped];
+		if (glClientWaitSync(result.fence, 0, 0) == GL_TIMEOUT_EXPIRED) break;
+
+		glDeleteSync(result.fence);
+		glDeleteProgram(result.shader->ID);
+		result.shader->ID = result.program;
+		std::cout << "Reloaded " << result.shader->stages.back().second << std::endl;
+	}
+	finished.erase(finished.begin(), finished.begin() + swapped);
+}
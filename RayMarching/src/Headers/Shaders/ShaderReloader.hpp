@@ -0,0 +1,51 @@
+#pragma once
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Shader.hpp"
+#include "../IO/FileWatcher.hpp"
+
+// Rebuilds shaders whose sources change on disk.
+// Programs are compiled on a hidden window whose context shares objects with the main one,
+// so the render loop never waits on the driver, and only replace the old program once they link
+class ShaderReloader {
+private:
+	struct Job {
+		Shader* shader;
+		Shader::Stages stages;
+		Shader::Defines defines;
+		std::vector<std::string> dependencies;
+	};
+
+	struct Result {
+		Shader* shader;
+		unsigned int program;
+		GLsync fence;
+	};
+
+	GLFWwindow* context = nullptr;
+	IO::FileWatcher watcher;
+	// Only touched by the loader thread
+	std::vector<Job> jobs;
+
+	std::mutex mutex;
+	std::vector<Result> finished;
+	std::atomic<bool> running = true;
+	std::thread loader;
+
+	void loop();
+
+public:
+	ShaderReloader(GLFWwindow* window, const std::string& shaderDir, const std::vector<Shader*>& shaders);
+	// Joins the loader and destroys its context, must happen before glfwTerminate
+	~ShaderReloader();
+	ShaderReloader(const ShaderReloader&) = delete;
+	ShaderReloader& operator=(const ShaderReloader&) = delete;
+
+	// Swaps in the programs the loader finished, call on the main thread before rendering
+	void update();
+};
@@ -0,0 +1,168 @@
+#include "Simulation.hpp"
+
+// After a longer stall (a breakpoint, a window drag) the lost steps are dropped instead of caught up
+constexpr int MaxCatchUpSteps = 30;
+
+static void copyScene(const Objects& objects, const LightingSystem& lightSys, Simulation::SceneInput& scene)
+{
+	scene.spheres = objects.spheres;
+	scene.cubes = objects.cubes;
+	scene.capsules = objects.capsules;
+	scene.primitives = objects.primitives;
+	scene.csgShapes = objects.csgShapes;
+	scene.pointLights = lightSys.pointLights;
+}
+
+Simulation::Simulation(const Camera& start, const Objects& objects, const LightingSystem& lightSys) : view(start.state())
+{
+	camera.setState(view);
+	// Never changes after the shaders are built
+	scene.csgProgram = objects.csgProgram;
+
+	Input& input = inputs.write();
+	input = { Camera::Controls(), view, viewEdit };
+	inputs.publish();
+
+	Snapshot& snapshot = snapshots.write();
+	snapshot = { view, look, Clock::now(), viewEdit, 0 };
+	snapshots.publish();
+
+	// The first frame draws a scene packed here, without a grid like publishScene() assumes
+	SceneInput& sceneInput = scenes.write();
+	copyScene(objects, lightSys, sceneInput);
+	sceneInput.buildGrid = sceneBuildGrid;
+	sceneInput.grid = sceneGrid;
+	pack(sceneInput, packedScenes.write());
+	packedScenes.publish();
+
+	thread = std::thread(&Simulation::run, this);
+}
+
+Simulation::~Simulation()
+{
+	running = false;
+	thread.join();
+}
+
+void Simulation::sampleInput(GLFWwindow* window)
+{
+	look += glm::vec2(xoffset, yoffset);
+
+	controls.enabled = useCam;
+	controls.look = look;
+	controls.forward = glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS;
+	controls.backward = glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS;
+	controls.left = glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS;
+	controls.right = glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS;
+
+	Input& input = inputs.write();
+	input.controls = controls;
+	input.view = view;
+	input.viewEdit = viewEdit;
+	inputs.publish();
+}
+
+void Simulation::setView(const CameraState& state)
+{
+	view = state;
+	++viewEdit;
+}
+
+CameraState Simulation::currentView()
+{
+	snapshots.update();
+	const Snapshot& snapshot = snapshots.read();
+	// Until the simulation has seen the last edit its cameras would undo it
+	if (snapshot.viewEdit != viewEdit) return view;
+
+	// The step can't have seen the input just sampled, it is applied here for the time since the step.
+	// The update thread integrates the same input on its next steps, this only moves the camera drawn
+	Camera::Controls pending = controls;
+	pending.look = controls.look - snapshot.look;
+	float elapsed = std::chrono::duration<float>(Clock::now() - snapshot.time).count();
+
+	predicted.setState(snapshot.camera);
+	predicted.update(pending, glm::clamp(elapsed, 0.0f, Step * MaxCatchUpSteps));
+	view = predicted.state();
+	return view;
+}
+
+void Simulation::publishScene(const Objects& objects, const LightingSystem& lightSys, const UniformGrid::Settings& grid, bool buildGrid, int edit)
+{
+	// Copying is O(objects), most frames nothing changed
+	if (edit == sceneEdit && buildGrid == sceneBuildGrid && grid == sceneGrid) return;
+	sceneEdit = edit;
+	sceneBuildGrid = buildGrid;
+	sceneGrid = grid;
+
+	SceneInput& scene = scenes.write();
+	copyScene(objects, lightSys, scene);
+	scene.buildGrid = buildGrid;
+	scene.grid = grid;
+	scenes.publish();
+}
+
+bool Simulation::updateScene()
+{
+	return packedScenes.update();
+}
+
+const Simulation::PackedScene& Simulation::latestScene() const
+{
+	return packedScenes.read();
+}
+
+void Simulation::pack(const SceneInput& input, PackedScene& packed)
+{
+	scene.spheres = input.spheres;
+	scene.cubes = input.cubes;
+	scene.capsules = input.capsules;
+	scene.primitives = input.primitives;
+	scene.csgShapes = input.csgShapes;
+	lights.pointLights = input.pointLights;
+
+	scene.pack(packed.objects);
+	lights.pack(packed.lights);
+	packed.hasGrid = input.buildGrid;
+	if (input.buildGrid) UniformGrid::build(packed.objects.bounds, input.grid, packed.grid);
+}
+
+void Simulation::run()
+{
+	const auto step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(Step));
+
+	inputs.update();
+	Input input = inputs.read();
+	glm::vec2 lastLook = input.controls.look;
+	int appliedEdit = input.viewEdit;
+	int stepIndex = 0;
+
+	auto next = Clock::now();
+	while (running) {
+		next += step;
+		auto now = Clock::now();
+		if (now - next > step * MaxCatchUpSteps) next = now;
+		else std::this_thread::sleep_until(next);
+
+		if (inputs.update()) input = inputs.read();
+		if (input.viewEdit != appliedEdit) {
+			camera.setState(input.view);
+			appliedEdit = input.viewEdit;
+		}
+
+		Camera::Controls controls = input.controls;
+		controls.look = input.controls.look - lastLook;
+		lastLook = input.controls.look;
+		camera.update(controls, Step);
+
+		Snapshot& snapshot = snapshots.write();
+		snapshot = { camera.state(), lastLook, next, appliedEdit, ++stepIndex };
+		snapshots.publish();
+
+		// Once per rendered frame, the scene only changes when the render thread publishes it
+		if (scenes.update()) {
+			pack(scenes.read(), packedScenes.write());
+			packedScenes.publish();
+		}
+	}
+}
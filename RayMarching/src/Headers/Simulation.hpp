@@ -0,0 +1,109 @@
+#pragma once
+#include <GLFW/glfw3.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "Camera.hpp"
+#include "Objects.hpp"
+#include "LightingSystem.hpp"
+#include "UniformGrid.hpp"
+#include "TripleBuffer.hpp"
+
+// The update thread. It moves the camera at a fixed rate, so input keeps being integrated at the same
+// pace however long a frame takes to render, and it packs the objects and lights and builds the grid
+// while the render thread draws. Everything crosses between the threads through triple buffers.
+// The render thread samples the keyboard and mouse (GLFW only allows that on the main thread) and
+// draws the newest camera step moved on by the input sampled since. It keeps its own Camera and
+// Objects, what the GUI or a scene load changes in them is sent over and the update thread goes on from there
+class Simulation {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr float Step = 1.0f / 120.0f; // In seconds
+
+	// Render thread to update thread, every frame
+	struct Input {
+		Camera::Controls controls; // look is the sum of every mouse offset so far, each step moves by the difference
+		CameraState view;
+		int viewEdit = 0; // Bumped whenever view was set from outside
+	};
+
+	// Render thread to update thread, the scene as the GUI left it, only sent when it changed
+	struct SceneInput {
+		std::vector<Sphere> spheres;
+		std::vector<Cube> cubes;
+		std::vector<Capsule> capsules;
+		std::vector<Primitive> primitives;
+		std::vector<CsgShape> csgShapes;
+		std::vector<PointLight> pointLights;
+		bool buildGrid = false;
+		UniformGrid::Settings grid;
+	};
+
+	// Update thread to render thread, one per step
+	struct Snapshot {
+		CameraState camera;
+		glm::vec2 look = { 0.0f, 0.0f }; // Input::controls.look the step went up to
+		Clock::time_point time; // The camera is where it is at this time
+		int viewEdit = 0; // Last edit the camera includes
+		int step = 0;
+	};
+
+	// Update thread to render thread, one per SceneInput
+	struct PackedScene {
+		PackedObjects objects;
+		PackedLights lights;
+		bool hasGrid = false;
+		UniformGrid::Build grid;
+	};
+
+private:
+	TripleBuffer<Input> inputs;
+	TripleBuffer<SceneInput> scenes;
+	TripleBuffer<Snapshot> snapshots;
+	TripleBuffer<PackedScene> packedScenes;
+	std::atomic<bool> running{ true };
+	std::thread thread;
+
+	// Render thread only
+	Camera::Controls controls;
+	glm::vec2 look = { 0.0f, 0.0f };
+	CameraState view;
+	int viewEdit = 0;
+	Camera predicted;
+	// What the last SceneInput was made from
+	int sceneEdit = 0;
+	bool sceneBuildGrid = false;
+	UniformGrid::Settings sceneGrid;
+
+	// Update thread only
+	Camera camera;
+	Objects scene;
+	LightingSystem lights;
+
+public:
+	// objects has to be compiled already, see Objects::compileCsg()
+	Simulation(const Camera& start, const Objects& objects, const LightingSystem& lightSys);
+	~Simulation();
+	Simulation(const Simulation&) = delete;
+	Simulation& operator=(const Simulation&) = delete;
+
+	// Render thread, once per frame right before the camera is needed and before processInput() clears the mouse offsets
+	void sampleInput(GLFWwindow* window);
+	// Render thread, the camera was moved from outside the simulation
+	void setView(const CameraState& state);
+	// Render thread, the camera to draw this frame
+	CameraState currentView();
+
+	// Render thread, once per frame after the GUI. edit has to change whenever the objects or point lights
+	// did (GUI::sceneEdit), the scene is only copied and sent when it or the grid parameters changed
+	void publishScene(const Objects& objects, const LightingSystem& lightSys, const UniformGrid::Settings& grid, bool buildGrid, int edit);
+	// Render thread, takes the newest packed scene, false when there was none since the last call
+	bool updateScene();
+	// Render thread, the packed scene taken by updateScene(), valid until it takes the next one
+	const PackedScene& latestScene() const;
+
+private:
+	void run();
+	void pack(const SceneInput& input, PackedScene& packed);
+};
@@ -0,0 +1,128 @@
+#include "StorageBuffer.hpp"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+// Buffer storage is core from 4.4 and the context asks for 4.3, so the entry point is loaded here when the driver has it
+typedef void (APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+static BufferStorageProc bufferStorage()
+{
+	static bool loaded = false;
+	static BufferStorageProc proc = nullptr;
+	if (loaded) return proc;
+	loaded = true;
+
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	if (major * 10 + minor >= 44 || glfwExtensionSupported("GL_ARB_buffer_storage"))
+		proc = reinterpret_cast<BufferStorageProc>(glfwGetProcAddress("glBufferStorage"));
+	if (!proc) std::cout << "No buffer storage, storage buffers are orphaned on every upload" << std::endl;
+	return proc;
+}
+
+// Slots are bound with glBindBufferRange, so they start on the driver's offset alignment
+static size_t slotAlignment()
+{
+	static GLint alignment = 0;
+	if (alignment == 0) glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	return static_cast<size_t>(std::max(alignment, 16));
+}
+
+StorageBuffer::StorageBuffer(unsigned int binding) : binding(binding)
+{
+}
+
+StorageBuffer::~StorageBuffer()
+{
+	release();
+}
+
+bool StorageBuffer::persistent()
+{
+	return bufferStorage() != nullptr;
+}
+
+void* StorageBuffer::map(size_t size)
+{
+	// An empty array still needs a buffer behind the binding
+	size_t bound = std::max<size_t>(size, 16);
+
+	if (!persistent()) {
+		if (ID == 0) glGenBuffers(1, &ID);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, ID);
+		if (bound > capacity) capacity = bound;
+		glBufferData(GL_SHADER_STORAGE_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+		return glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, bound, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	}
+
+	if (mapped) {
+		// Everything sent since the last map() may read the slot being left
+		if (fences[slot]) glDeleteSync(fences[slot]);
+		fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		slot = (slot + 1) % Slots;
+	}
+
+	if (bound > capacity) allocate(bound);
+	else if (fences[slot]) {
+		while (glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED);
+		glDeleteSync(fences[slot]);
+		fences[slot] = nullptr;
+	}
+
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, ID, slot * capacity, bound);
+	return mapped + slot * capacity;
+}
+
+void StorageBuffer::unmap()
+{
+	// The persistent mapping is coherent, the writes are seen without any call
+	if (persistent()) return;
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ID);
+	glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, ID);
+}
+
+void StorageBuffer::upload(const void* data, size_t size)
+{
+	void* destination = map(size);
+	if (size > 0) std::memcpy(destination, data, size);
+	unmap();
+}
+
+// A new ring, the old buffer is only freed by the driver once the GPU is done with it
+void StorageBuffer::allocate(size_t size)
+{
+	release();
+
+	size_t alignment = slotAlignment();
+	capacity = (size + alignment - 1) / alignment * alignment;
+	slot = 0;
+
+	constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glGenBuffers(1, &ID);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ID);
+	bufferStorage()(GL_SHADER_STORAGE_BUFFER, capacity * Slots, nullptr, flags);
+	mapped = static_cast<char*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, capacity * Slots, flags));
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void StorageBuffer::release()
+{
+	for (GLsync& fence : fences) {
+		if (fence) glDeleteSync(fence);
+		fence = nullptr;
+	}
+	// Deleting a mapped buffer unmaps it
+	if (ID != 0) glDeleteBuffers(1, &ID);
+	ID = 0;
+	mapped = nullptr;
+}
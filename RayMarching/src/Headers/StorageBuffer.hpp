@@ -0,0 +1,48 @@
+#pragma once
+#include <glad/glad.h>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// Shader storage buffer attached to a fixed binding point, grows to fit the uploaded data.
+// When the driver has buffer storage it is a ring of Slots persistently mapped slots: every map()
+// writes the next slot and only waits if the GPU is still reading what was written there Slots maps ago.
+// Otherwise every map() orphans the buffer
+class StorageBuffer {
+public:
+	static constexpr int Slots = 3;
+
+private:
+	unsigned int ID = 0;
+	size_t capacity = 0; // Of one slot
+	unsigned int binding;
+
+	// Persistent ring
+	char* mapped = nullptr;
+	int slot = 0;
+	std::array<GLsync, Slots> fences{};
+
+public:
+	explicit StorageBuffer(unsigned int binding);
+	~StorageBuffer();
+	StorageBuffer(const StorageBuffer&) = delete;
+	StorageBuffer& operator=(const StorageBuffer&) = delete;
+
+	// Room for size bytes that the shaders read from the next commands on, written until unmap()
+	void* map(size_t size);
+	void unmap();
+	void upload(const void* data, size_t size);
+
+	template<typename T>
+	T* map(size_t count) { return static_cast<T*>(map(count * sizeof(T))); }
+
+	template<typename T>
+	void upload(const std::vector<T>& data) { upload(data.data(), data.size() * sizeof(T)); }
+
+	// True when the buffers are persistently mapped rings
+	static bool persistent();
+
+private:
+	void allocate(size_t size);
+	void release();
+};
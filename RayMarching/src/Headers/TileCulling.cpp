@@ -0,0 +1,107 @@
+#include "TileCulling.hpp"
+#include <algorithm>
+#include <cmath>
+#include "IO/Input.hpp"
+
+// Signed distance from a camera space point to the plane through the camera holding the rays
+// of slope u along one axis (dir = (u, *, -1) for x), positive on the side of the larger slopes
+static float planeDist(glm::vec3 point, int axis, float u)
+{
+	return (point[axis] + u * point.z) / std::sqrt(1.0f + u * u);
+}
+
+void TileCulling::upload(const std::vector<ObjectBounds>& objects, const Camera& camera, float maxDist)
+{
+	glm::vec2 resolution(SCR_WIDTH, SCR_HEIGHT);
+	tilesX = (SCR_WIDTH + tileSize - 1) / tileSize;
+	tilesY = (SCR_HEIGHT + tileSize - 1) / tileSize;
+	int tileCount = tilesX * tilesY;
+
+	// Ray slopes at the tile edges, as in getRayDirection(). Tiles are grown by a pixel
+	// on every side so the sub-pixel jitter of the temporal modes stays inside them
+	glm::vec2 scale = glm::vec2(resolution.x / resolution.y, 1.0f) * 0.5f;
+	auto slope = [&](int axis, int pixel) {
+		return (2.0f * pixel / resolution[axis] - 1.0f) * scale[axis];
+	};
+
+	// First and last tile along an axis the sphere reaches, x > y when none.
+	// The tiles it reaches are contiguous, the planes all go through the camera
+	int counts[2] = { tilesX, tilesY };
+	auto tileRange = [&](glm::vec3 center, float radius, int axis) {
+		glm::ivec2 range(counts[axis], -1);
+		for (int t = 0; t < counts[axis]; ++t) {
+			if (planeDist(center, axis, slope(axis, t * tileSize - 1)) < -radius) continue;
+			if (planeDist(center, axis, slope(axis, (t + 1) * tileSize + 1)) > radius) continue;
+			range.x = std::min(range.x, t);
+			range.y = t;
+		}
+		return range;
+	};
+
+	struct Rect {
+		int object;
+		glm::ivec2 x, y;
+	};
+	std::vector<Rect> rects;
+	objectList.clear();
+	culled = 0;
+
+	for (const ObjectBounds& object : objects) {
+		glm::vec3 center = camera.viewMatrix * ((object.bounds.min + object.bounds.max) * 0.5f - camera.Position);
+		float radius = glm::length(object.bounds.max - object.bounds.min) * 0.5f;
+
+		// Too large to be worth listing per tile, like the planes
+		if (radius > maxDist) {
+			objectList.push_back(object.object);
+			continue;
+		}
+
+		// Behind the camera or past the end of every ray
+		if (center.z > radius || glm::length(center) - radius > maxDist) {
+			++culled;
+			continue;
+		}
+
+		Rect rect{ object.object, tileRange(center, radius, 0), tileRange(center, radius, 1) };
+		if (rect.x.x > rect.x.y || rect.y.x > rect.y.y) {
+			++culled;
+			continue;
+		}
+		rects.push_back(rect);
+	}
+	unboundedCount = static_cast<int>(objectList.size());
+
+	// Counting sort of the rectangles into the tiles
+	offsets.assign(tileCount, 0);
+	for (const Rect& rect : rects)
+		for (int y = rect.y.x; y <= rect.y.y; ++y)
+			for (int x = rect.x.x; x <= rect.x.y; ++x)
+				++offsets[x + y * tilesX];
+
+	tiles.assign(tileCount, Tile());
+	int offset = unboundedCount;
+	for (int tile = 0; tile < tileCount; ++tile) {
+		tiles[tile].start = offset;
+		tiles[tile].count = offsets[tile];
+		offsets[tile] = offset;
+		offset += tiles[tile].count;
+	}
+	references = offset - unboundedCount;
+	objectList.resize(offset);
+
+	for (const Rect& rect : rects)
+		for (int y = rect.y.x; y <= rect.y.y; ++y)
+			for (int x = rect.x.x; x <= rect.x.y; ++x)
+				objectList[offsets[x + y * tilesX]++] = rect.object;
+
+	tileBuffer.upload(tiles);
+	objectBuffer.upload(objectList);
+}
+
+void TileCulling::update(Shader& shader, bool enabled) const
+{
+	shader.setBool("useTileCulling", enabled);
+	shader.setInt("cullTileSize", tileSize);
+	shader.setInt("cullTilesX", tilesX);
+	shader.setInt("cullUnbounded", unboundedCount);
+}
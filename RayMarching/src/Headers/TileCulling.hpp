@@ -0,0 +1,43 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include "Shaders/Shader.hpp"
+#include "StorageBuffer.hpp"
+#include "Objects.hpp"
+#include "Camera.hpp"
+
+// Per screen tile lists of the spheres, cubes, capsules and primitives whose bounding spheres reach
+// into the tile's frustum, rebuilt on the CPU every frame. Primary rays only march the objects of
+// their tile (tileDist() in RayMarching.glsl), every other ray can leave the frustum and tests all
+class TileCulling {
+public:
+	int tileSize = 16; // In pixels
+
+	// Last build
+	int tilesX = 0;
+	int tilesY = 0;
+	int unboundedCount = 0;
+	int references = 0; // Object entries over all tiles
+	int culled = 0; // Objects outside every tile
+
+private:
+	// std430 layout of CullTile in RayMarching.glsl
+	struct Tile {
+		int start = 0;
+		int count = 0;
+	};
+
+	std::vector<Tile> tiles;
+	// Unbounded objects first, then the list of every tile
+	std::vector<int> objectList;
+	std::vector<int> offsets;
+
+	StorageBuffer tileBuffer{ 16 };
+	StorageBuffer objectBuffer{ 17 };
+
+public:
+	// Rebuilds the lists for the camera as it is now and uploads them, objects are PackedObjects::bounds
+	// of the uploaded objects and maxDist is RenderSettings::maxDist
+	void upload(const std::vector<ObjectBounds>& objects, const Camera& camera, float maxDist);
+	void update(Shader& shader, bool enabled) const;
+};
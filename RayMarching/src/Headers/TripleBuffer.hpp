@@ -0,0 +1,33 @@
+#pragma once
+#include <array>
+#include <atomic>
+
+// Hands values from one writer thread to one reader thread without locks. Each side keeps a slot of
+// its own and the third one sits between them: publish() swaps the writer's slot with it, update()
+// swaps it with the reader's if something new was published. The reader always sees the newest
+// complete value, older ones are dropped, and neither side ever waits for the other
+template<typename T>
+class TripleBuffer {
+private:
+	// Set in the shared index while it holds a value the reader has not taken yet
+	static constexpr int Fresh = 4;
+
+	std::array<T, 3> slots{};
+	std::atomic<int> shared{ 1 };
+	int back = 0; // Writer's slot
+	int front = 2; // Reader's slot
+
+public:
+	// Writer: the slot to fill, it holds an old value so every field has to be written
+	T& write() { return slots[back]; }
+	void publish() { back = shared.exchange(back | Fresh, std::memory_order_acq_rel) & ~Fresh; }
+
+	// Reader: takes the newest published value, false when there was none since the last call
+	bool update()
+	{
+		if (!(shared.load(std::memory_order_relaxed) & Fresh)) return false;
+		front = shared.exchange(front, std::memory_order_acq_rel) & ~Fresh;
+		return true;
+	}
+	const T& read() const { return slots[front]; }
+};
@@ -0,0 +1,169 @@
+#include "UniformGrid.hpp"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+// Below this many objects the build stays on the calling thread
+constexpr int ParallelThreshold = 512;
+constexpr int MaxThreads = 4;
+
+void UniformGrid::build(const std::vector<ObjectBounds>& objects, const Settings& settings, Build& grid)
+{
+	const float maxExtent = settings.maxExtent;
+	std::vector<int>& objectList = grid.objectList;
+	std::vector<Cell>& cellData = grid.cellData;
+	glm::vec3& origin = grid.origin;
+	glm::ivec3& cells = grid.cells;
+	float& cellSize = grid.cellSize;
+
+	// Objects too large for the grid go at the front of the list and are tested everywhere
+	std::vector<ObjectBounds> bounded;
+	objectList.clear();
+	for (const ObjectBounds& object : objects) {
+		bool inside = true;
+		for (int axis = 0; axis < 3; ++axis)
+			inside = inside && object.bounds.min[axis] >= -maxExtent && object.bounds.max[axis] <= maxExtent;
+		if (inside) bounded.push_back(object);
+		else objectList.push_back(object.object);
+	}
+	grid.unboundedCount = static_cast<int>(objectList.size());
+
+	Bounds box{ glm::vec3(0.0f), glm::vec3(0.0f) };
+	if (!bounded.empty()) box = bounded[0].bounds;
+	for (const ObjectBounds& object : bounded) {
+		box.min = glm::min(box.min, object.bounds.min);
+		box.max = glm::max(box.max, object.bounds.max);
+	}
+
+	// Cubic cells, about cellsPerObject of them per object, and a margin of one cell on every side.
+	// The cells have to stay larger than the march epsilon, their size is the step through them
+	glm::vec3 size = glm::max(box.max - box.min, glm::vec3(0.01f));
+	float target = static_cast<float>(glm::max(static_cast<int>(bounded.size()), 1) * settings.cellsPerObject);
+	float largest = glm::max(size.x, glm::max(size.y, size.z));
+	cellSize = std::cbrt(size.x * size.y * size.z / target);
+	cellSize = glm::max(cellSize, glm::max(largest / (settings.maxCellsPerAxis - 2), 0.05f));
+	origin = box.min - glm::vec3(cellSize);
+	cells = glm::min(glm::ivec3(glm::ceil(size / cellSize)) + glm::ivec3(2), glm::ivec3(settings.maxCellsPerAxis));
+	int cellCount = cells.x * cells.y * cells.z;
+
+	// Cells an object is listed in, its bounds grown by one cell
+	auto forEachCell = [&](const Bounds& bounds, auto&& visit) {
+		glm::ivec3 low = glm::clamp(glm::ivec3(glm::floor((bounds.min - origin) / cellSize)) - glm::ivec3(1), glm::ivec3(0), cells - glm::ivec3(1));
+		glm::ivec3 high = glm::clamp(glm::ivec3(glm::floor((bounds.max - origin) / cellSize)) + glm::ivec3(1), glm::ivec3(0), cells - glm::ivec3(1));
+		for (int z = low.z; z <= high.z; ++z)
+			for (int y = low.y; y <= high.y; ++y)
+				for (int x = low.x; x <= high.x; ++x)
+					visit(x + cells.x * (y + cells.y * z));
+	};
+
+	// Counting sort, every thread counts and then scatters its own slice of the objects
+	int objectCount = static_cast<int>(bounded.size());
+	int threads = 1;
+	if (objectCount >= ParallelThreshold)
+		threads = glm::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, MaxThreads);
+	std::vector<std::vector<int>> threadCounts(threads);
+
+	auto parallel = [threads](auto job) {
+		if (threads == 1) {
+			job(0);
+			return;
+		}
+		std::vector<std::thread> workers;
+		for (int t = 0; t < threads; ++t) workers.emplace_back(job, t);
+		for (std::thread& worker : workers) worker.join();
+	};
+
+	parallel([&](int t) {
+		std::vector<int>& counts = threadCounts[t];
+		counts.assign(cellCount, 0);
+		for (int i = objectCount * t / threads; i < objectCount * (t + 1) / threads; ++i)
+			forEachCell(bounded[i].bounds, [&counts](int cell) { ++counts[cell]; });
+	});
+
+	// Cell major, so every cell's list is contiguous and keeps the object order
+	cellData.assign(cellCount, Cell());
+	int offset = grid.unboundedCount;
+	for (int cell = 0; cell < cellCount; ++cell) {
+		cellData[cell].start = offset;
+		for (int t = 0; t < threads; ++t) {
+			int count = threadCounts[t][cell];
+			threadCounts[t][cell] = offset;
+			offset += count;
+		}
+		cellData[cell].count = offset - cellData[cell].start;
+	}
+	grid.references = offset - grid.unboundedCount;
+	objectList.resize(offset);
+
+	parallel([&](int t) {
+		std::vector<int>& next = threadCounts[t];
+		for (int i = objectCount * t / threads; i < objectCount * (t + 1) / threads; ++i) {
+			int object = bounded[i].object;
+			forEachCell(bounded[i].bounds, [&](int cell) { objectList[next[cell]++] = object; });
+		}
+	});
+
+	computeEmptyDistances(grid);
+}
+
+void UniformGrid::upload(const Build& grid)
+{
+	origin = grid.origin;
+	cells = grid.cells;
+	cellSize = grid.cellSize;
+	unboundedCount = grid.unboundedCount;
+	references = grid.references;
+
+	cellBuffer.upload(grid.cellData);
+	objectBuffer.upload(grid.objectList);
+}
+
+void UniformGrid::update(Shader& shader, bool enabled) const
+{
+	shader.setBool("useGrid", enabled);
+	shader.setVec3("gridOrigin", origin);
+	shader.setFloat("gridCellSize", cellSize);
+	shader.setIVec3("gridCells", cells);
+	shader.setInt("gridUnbounded", unboundedCount);
+}
+
+// Every object lies at least a cell inside the cells listing it, so a point in an empty cell
+// k cells (in the max norm) from the nearest listed one is at least k cells from any object
+void UniformGrid::computeEmptyDistances(Build& grid)
+{
+	std::vector<Cell>& cellData = grid.cellData;
+	const glm::ivec3 cells = grid.cells;
+	constexpr int Far = 1 << 20;
+	std::vector<int> distance(cellData.size());
+	for (int cell = 0; cell < static_cast<int>(cellData.size()); ++cell)
+		distance[cell] = cellData[cell].count > 0 ? 0 : Far;
+
+	// Two chamfer passes, each over the half of the 26 neighbors already visited in its scan order
+	for (int pass = 0; pass < 2; ++pass) {
+		int step = pass == 0 ? 1 : -1;
+		for (int i = 0; i < cells.z; ++i) {
+			int z = pass == 0 ? i : cells.z - 1 - i;
+			for (int j = 0; j < cells.y; ++j) {
+				int y = pass == 0 ? j : cells.y - 1 - j;
+				for (int k = 0; k < cells.x; ++k) {
+					int x = pass == 0 ? k : cells.x - 1 - k;
+					int& current = distance[x + cells.x * (y + cells.y * z)];
+
+					for (int dz = -1; dz <= 0; ++dz)
+						for (int dy = -1; dy <= 1; ++dy)
+							for (int dx = -1; dx <= 1; ++dx) {
+								if (dz == 0 && (dy > 0 || (dy == 0 && dx >= 0))) continue;
+								int nx = x + dx * step, ny = y + dy * step, nz = z + dz * step;
+								if (nx < 0 || ny < 0 || nz < 0 || nx >= cells.x || ny >= cells.y || nz >= cells.z) continue;
+								current = std::min(current, distance[nx + cells.x * (ny + cells.y * nz)] + 1);
+							}
+				}
+			}
+		}
+	}
+
+	for (int cell = 0; cell < static_cast<int>(cellData.size()); ++cell) {
+		if (cellData[cell].count > 0) continue;
+		cellData[cell].empty = distance[cell] == Far ? 1e30f : distance[cell] * grid.cellSize;
+	}
+}
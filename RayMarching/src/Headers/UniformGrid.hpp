@@ -0,0 +1,63 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include "Shaders/Shader.hpp"
+#include "StorageBuffer.hpp"
+#include "Objects.hpp"
+
+// Uniform grid over the spheres, cubes, capsules and primitives, rebuilt from scratch every frame.
+// Each cell lists the objects whose bounds come within one cell of it, so gridDist() in
+// RayMarching.glsl only evaluates those, and empty cells store how far the nearest listed
+// object is at least, which the march can step at once
+class UniformGrid {
+public:
+	struct Settings {
+		int cellsPerObject = 4; // Target cell count relative to the object count
+		int maxCellsPerAxis = 64;
+		float maxExtent = 100.0f; // Objects reaching past it are tested at every step instead of gridded
+
+		bool operator==(const Settings&) const = default;
+	};
+
+	// std430 layout of GridCell in RayMarching.glsl
+	struct Cell {
+		int start = 0;
+		int count = 0;
+		float empty = 0.0f; // Lower bound on the distance to every object, for cells without any
+		int padding = 0;
+	};
+
+	// What build() makes, plain data so the update thread can build it and the render thread upload it
+	struct Build {
+		glm::vec3 origin = glm::vec3(0.0f);
+		glm::ivec3 cells = glm::ivec3(1);
+		float cellSize = 1.0f;
+		int unboundedCount = 0;
+		int references = 0; // Object entries over all cells
+		std::vector<Cell> cellData;
+		// Unbounded objects first, then the list of every cell
+		std::vector<int> objectList;
+	};
+
+	Settings settings;
+
+	// Last upload
+	glm::vec3 origin = glm::vec3(0.0f);
+	glm::ivec3 cells = glm::ivec3(1);
+	float cellSize = 1.0f;
+	int unboundedCount = 0;
+	int references = 0;
+
+private:
+	StorageBuffer cellBuffer{ 14 };
+	StorageBuffer objectBuffer{ 15 };
+
+public:
+	// Rebuilds the grid from scratch over the objects, any thread
+	static void build(const std::vector<ObjectBounds>& objects, const Settings& settings, Build& grid);
+	void upload(const Build& grid);
+	void update(Shader& shader, bool enabled) const;
+
+private:
+	static void computeEmptyDistances(Build& grid);
+};
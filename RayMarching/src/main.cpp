@@ -4,26 +4,53 @@
 *	-Fragment Shader is where everything happens
 * 2. Send the positions and size of each objects to the gpu
 * 3. In the quad's fragment shader cast 'rays' and calculate point of intersections
+* Alternatively (RenderMode::Compute) a compute shader marches screen tiles into a texture that is blitted to the screen,
+* or (RenderMode::Wavefront) primary, shadow and reflection rays each get their own compute pass over compacted queues
 */
 // OpenGL
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 // Other
 #include <iostream>
+#include <cstring>
+#include <memory>
 // My headers
 #include "Headers/Shaders/Shader.hpp"
+#include "Headers/Shaders/ShaderReloader.hpp"
 #include "Headers/LightingSystem.hpp"
 #include "Headers/IO/Input.hpp"
 #include "Headers/Objects.hpp"
 #include "Headers/Camera.hpp"
+#include "Headers/RenderSettings.hpp"
+#include "Headers/Renderer.hpp"
+#include "Headers/BrickMap.hpp"
+#include "Headers/UniformGrid.hpp"
+#include "Headers/TileCulling.hpp"
+#include "Headers/FrameUniforms.hpp"
+#include "Headers/Simulation.hpp"
+#include "Headers/FramePacer.hpp"
+#include "Headers/Benchmark.hpp"
+#include "Headers/Scene.hpp"
 #include "Headers/GUI.hpp"
 
 using namespace IO;
 
-int main() {
+int main(int argc, char** argv) {
+	// --benchmark: sweep every render mode, print the GPU timings and exit
+	// --scene <path>: load a scene file (.scene text or .sceneb binary) instead of the built in one
+	// --shaders <dir>: read the shaders from disk and hot reload them, instead of the embedded copies
+	bool benchmarkOnly = false;
+	std::string scenePath;
+	std::string shaderDir;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--benchmark") == 0) benchmarkOnly = true;
+		else if (std::strcmp(argv[i], "--scene") == 0 && i + 1 < argc) scenePath = argv[++i];
+		else if (std::strcmp(argv[i], "--shaders") == 0 && i + 1 < argc) shaderDir = std::string(argv[++i]) + "/";
+	}
+
 #pragma region init
 	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 #pragma endregion
@@ -35,7 +62,6 @@ int main() {
 		return EXIT_FAILURE;
 	}
 	glfwMakeContextCurrent(window);
-	glfwSwapInterval(1);
 
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 	glfwSetCursorPosCallback(window, mouse_callback);
@@ -47,45 +73,6 @@ int main() {
 	}
 #pragma endregion
 
-#pragma region Shader
-	const std::string VertexPath = "C:\\Users\\alexa\\OneDrive\\Coding\\C++\\RayMarching\\RayMarching\\res\\Shaders\\Shader.vert";
-	const std::string FragPath = "C:\\Users\\alexa\\OneDrive\\Coding\\C++\\RayMarching\\RayMarching\\res\\Shaders\\Shader.frag";
-
-	Shader shader(VertexPath, FragPath);
-#pragma endregion
-
-#pragma region Quad
-	constexpr float size = 1.0f;
-	float vertices[] = {
-		-size, -size, 0.0f, // Bottom right
-		size, -size, 0.0f, // Bottom left
-		size,  size, 0.0f, // Top left
-		-size,  size, 0.0f // Top Right
-	};
-
-	unsigned int indices[] = {
-		0, 1, 2,
-		2, 3, 0
-	};
-
-	unsigned int VAO, VBO, EBO;
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-	glGenBuffers(1, &EBO);
-
-	glBindVertexArray(VAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	glBindVertexArray(0);
-#pragma endregion
-
 #pragma region Objects
 	Objects objects;
 	objects.addSphere({ 1.0f, {0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 1.0f}, 0.0f });
@@ -99,63 +86,166 @@ int main() {
 
 	objects.addCapsule({ { 0.0f, 2.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, { 1.0f,1.0f,-2.5f }, { 1.0f,1.0f,2.5f }, { 1.0f,1.0f,1.0f }, 0.0f, 1.0f });
 
+	Primitive torus = Primitives::create(Primitives::find("Torus"));
+	torus.center = { 4.0f, 1.0f, 3.0f };
+	torus.rotation = { 30.0f, 0.0f, 0.0f };
+	torus.color = { 0.9f, 0.6f, 0.2f };
+	objects.addPrimitive(torus);
+
+	// Hollow cylinder with a smoothly blended rim, slightly bent
+	CsgShape vase;
+	Primitive body = Primitives::create(Primitives::find("Cylinder"));
+	body.center = { -4.0f, 1.2f, 4.0f };
+	Primitive hole = Primitives::create(Primitives::find("Cylinder"));
+	hole.center = body.center + glm::vec3(0.0f, 0.3f, 0.0f);
+	hole.a = { 0.35f, 1.0f, 0.0f, 0.0f };
+	Primitive rim = Primitives::create(Primitives::find("Torus"));
+	rim.center = body.center + glm::vec3(0.0f, 1.0f, 0.0f);
+	rim.a = { 0.45f, 0.12f, 0.0f, 0.0f };
+	int cup = vase.combine(Csg::Op::Subtract, vase.leaf(body), vase.leaf(hole));
+	vase.root = vase.bend(vase.combine(Csg::Op::Union, cup, vase.leaf(rim), 0.2f), 0.5f, body.center - glm::vec3(0.0f, 1.0f, 0.0f));
+	vase.color = { 0.3f, 0.5f, 0.9f };
+	objects.addCsgShape(vase);
+
+	// Interpreted from bytecode, leaves can be added to it from the GUI without a shader compile
+	CsgShape blob;
+	blob.dynamic = true;
+	Primitive lobe = Primitives::create(Primitives::find("Ellipsoid"));
+	lobe.center = { 4.0f, 1.0f, -3.0f };
+	Primitive cone = Primitives::create(Primitives::find("Cone"));
+	cone.center = lobe.center + glm::vec3(0.0f, 0.8f, 0.0f);
+	blob.root = blob.combine(Csg::Op::Union, blob.leaf(lobe), blob.leaf(cone), 0.4f);
+	blob.color = { 0.4f, 0.9f, 0.4f };
+	objects.addCsgShape(blob);
+
+	// One tower repeated on a 13x13 grid, each copy shrunk around its base by a random amount
+	CsgShape city;
+	Primitive tower = Primitives::create(Primitives::find("HexPrism"));
+	tower.center = { 0.0f, 2.0f, -30.0f };
+	tower.rotation = { 90.0f, 0.0f, 0.0f };
+	tower.a = { 0.6f, 2.0f, 0.0f, 0.0f };
+	city.root = city.repeat(city.leaf(tower), { 2.5f, 0.0f, 2.5f }, { 6, 0, 6 }, 0.6f, { 0.0f, 0.0f, -30.0f });
+	city.color = { 0.7f, 0.7f, 0.75f };
+	objects.addCsgShape(city);
+
 	LightingSystem lightSys;
 	lightSys.addPointLight(PointLight({ 0.0f, 5.0f, 0.0f }));
 	lightSys.addPointLight(PointLight({ 3.0f, 5.0f, 1.0f }));
-	
-	Camera camera(window, shader);
+#pragma endregion
+
+#pragma region Renderer
+	Shader::useEmbedded = shaderDir.empty();
+	Shader::generatedSources["Primitives.glsl"] = Primitives::generateGLSL();
+	Shader::generatedSources["Csg.glsl"] = objects.compileCsg();
+	Renderer renderer(shaderDir);
+	BrickMap brickMap(shaderDir);
+	UniformGrid grid;
+	TileCulling culling;
+	FrameUniforms frameUniforms;
+
+	std::unique_ptr<ShaderReloader> shaderReloader;
+	if (!Shader::useEmbedded) {
+		std::vector<Shader*> shaders = renderer.getAllShaders();
+		shaders.push_back(&brickMap.bakeShader);
+		shaderReloader = std::make_unique<ShaderReloader>(window, shaderDir, shaders);
+	}
+#pragma endregion
+
+#pragma region Camera and Settings
+	Camera camera;
+	if (!scenePath.empty()) Scene::load(scenePath, objects, lightSys, camera);
+	// Moves its own copy of the camera and packs the objects from here on, see the Inputs region
+	Simulation simulation(camera, objects, lightSys);
+
+	RenderSettings settings;
+	FramePacer pacer; // Sets the swap interval
+	Benchmark benchmark;
+	if (benchmarkOnly) benchmark.start(settings);
 #pragma endregion
 
 #pragma region GUI
-	GUI gui(window, camera, objects, lightSys);
+	GUI gui(window, camera, objects, lightSys, settings, benchmark, brickMap, grid, culling, pacer, scenePath);
 #pragma endregion
 
 #pragma region Time Variables
 	float time = 0.0f;
-	float lastTime = 0.0f;
-	float dt = 0.0f;
 #pragma endregion
 
 	while (!glfwWindowShouldClose(window)) {
+		// Waits for the frame rate cap and the GPU before any input is read
+		pacer.beginFrame();
+
 #pragma region Time
 		time = static_cast<float>(glfwGetTime());
-		dt = time - lastTime;
-		lastTime = time;
+#pragma endregion
+
+#pragma region Scene
+		if (shaderReloader) shaderReloader->update();
+
+		// Packed on the update thread from an earlier publishScene(), only copied into the buffers here
+		// when it is new. The buffers keep the last upload until then
+		bool newScene = simulation.updateScene();
+		const Simulation::PackedScene& scene = simulation.latestScene();
+		if (newScene) {
+			objects.upload(scene.objects);
+			lightSys.upload(scene.lights);
+			brickMap.validate(objects);
+			if (scene.hasGrid) grid.upload(scene.grid);
+		}
+		bool useGrid = settings.lookup == SceneLookup::Grid && scene.hasGrid;
 #pragma endregion
 
 #pragma region Inputs
+		// Events are polled once, as late as possible: the GUI and the camera both see them this frame
+		// and only the work that depends on the camera is left before the draw
 		glfwPollEvents();
 
-		shader.use();
-		camera.update(window, shader, dt);
-
+		// GUI edits and scene loads move the render thread's camera, the simulation continues from them
+		CameraState shown = camera.state();
 		gui.update();
+		if (camera.state() != shown) simulation.setView(camera.state());
+		simulation.publishScene(objects, lightSys, grid.settings, settings.lookup == SceneLookup::Grid, gui.sceneEdit);
 
+		simulation.sampleInput(window);
 		processInput(window);
+		camera.present(simulation.currentView());
+		pacer.inputSampled();
 #pragma endregion
 
 #pragma region Render
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT);
 
-		shader.use();
 		/*
 		for (Cube& cube : objects.cubes) {
 			cube.center.x *= rand() % (int)time;
 			cube.rotation.z *= rand() % (int)sin(time);
 		}*/
 
-		objects.update(shader);
-		lightSys.update(shader);
-
-		glBindVertexArray(VAO);
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+		// Built here and not on the update thread, the lists have to match the camera drawn exactly
+		if (settings.tileCulling) culling.upload(scene.objects.bounds, camera, settings.maxDist);
+		frameUniforms.update(camera, lightSys, settings, time, renderer.getFrameIndex());
+		for (Shader* shader : renderer.getShaders(settings.mode)) {
+			shader->use();
+			objects.update(*shader);
+			lightSys.update(*shader);
+			settings.update(*shader);
+			brickMap.update(*shader, settings.useBrickMap);
+			grid.update(*shader, useGrid);
+			culling.update(*shader, settings.tileCulling);
+		}
+
+		benchmark.begin();
+		renderer.render(settings, lightSys);
+		if (benchmark.end(settings) && benchmarkOnly) glfwSetWindowShouldClose(window, true);
 
 		gui.render();
 
 		glfwSwapBuffers(window);
+		pacer.endFrame();
 #pragma endregion
 	}
+	shaderReloader.reset();
 	glfwTerminate();
 
 	return EXIT_SUCCESS;
@@ -0,0 +1,69 @@
+"""Pre-build step: writes every shader in a directory into a C++ header as constexpr strings,
+so release builds read no shader files at startup.
+
+usage: embed_shaders.py <shader dir> <output header>
+"""
+import os
+import sys
+
+EXTENSIONS = (".vert", ".frag", ".geom", ".comp", ".glsl")
+# MSVC rejects string literals over 16K, so long files are split into concatenated pieces
+CHUNK = 8000
+DELIMITER = "SHADER"
+
+
+def literal(source):
+    pieces = []
+    piece = ""
+    for line in source.splitlines(keepends=True):
+        if piece and len(piece) + len(line) > CHUNK:
+            pieces.append(piece)
+            piece = ""
+        piece += line
+    pieces.append(piece)
+    return "\n".join('R"{0}({1}){0}"'.format(DELIMITER, p) for p in pieces)
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    shader_dir, output = sys.argv[1], sys.argv[2]
+
+    names = sorted(n for n in os.listdir(shader_dir) if n.endswith(EXTENSIONS))
+    entries = []
+    for name in names:
+        with open(os.path.join(shader_dir, name), encoding="utf-8") as f:
+            source = f.read()
+        if ")" + DELIMITER + '"' in source:
+            sys.exit("{}: contains the raw string delimiter".format(name))
+        entries.append('\t\t{{ "{}",\n{} }},'.format(name, literal(source)))
+
+    header = (
+        "// Generated by tools/embed_shaders.py from res/Shaders, do not edit\n"
+        "#pragma once\n"
+        "#include <array>\n"
+        "#include <string_view>\n"
+        "\n"
+        "namespace EmbeddedShaders {\n"
+        "\tstruct File {\n"
+        "\t\tstd::string_view name;\n"
+        "\t\tstd::string_view source;\n"
+        "\t};\n"
+        "\n"
+        "\tinline constexpr std::array<File, " + str(len(entries)) + "> files = {{\n"
+        + "\n".join(entries) + "\n"
+        "\t}};\n"
+        "}\n"
+    )
+
+    # Leave the header alone when nothing changed so it doesn't trigger a rebuild
+    if os.path.exists(output):
+        with open(output, encoding="utf-8") as f:
+            if f.read() == header:
+                return
+    with open(output, "w", encoding="utf-8", newline="\n") as f:
+        f.write(header)
+
+
+if __name__ == "__main__":
+    main()